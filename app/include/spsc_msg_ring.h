@@ -0,0 +1,45 @@
+#ifndef SPSC_MSG_RING_H
+#define SPSC_MSG_RING_H
+
+#include <stdint.h>
+
+#include "spsc_ring.h"
+
+typedef struct spsc_msg_ring spsc_msg_ring_t;
+
+spsc_msg_ring_t *spsc_msg_ring_init(uint32_t capacity_bytes);
+
+spsc_msg_ring_t *spsc_msg_ring_init_ex(uint32_t capacity_bytes, uint32_t flags);
+
+uint32_t spsc_msg_ring_max_msg(spsc_msg_ring_t *ring);
+
+void *spsc_msg_ring_reserve(spsc_msg_ring_t *ring, uint32_t len);
+
+int spsc_msg_ring_commit(spsc_msg_ring_t *ring, uint32_t len);
+
+int spsc_msg_ring_push(spsc_msg_ring_t *ring, const void *data, uint32_t len);
+
+int spsc_msg_ring_push_wait(spsc_msg_ring_t *ring, const void *data, uint32_t len,
+                            int64_t timeout_ns);
+
+int spsc_msg_ring_set_stream(spsc_msg_ring_t *ring, uint32_t min_bytes);
+
+const void *spsc_msg_ring_peek(spsc_msg_ring_t *ring, uint32_t *out_len);
+
+const void *spsc_msg_ring_peek_wait(spsc_msg_ring_t *ring, uint32_t *out_len, int64_t timeout_ns);
+
+int spsc_msg_ring_release(spsc_msg_ring_t *ring);
+
+int spsc_msg_ring_is_empty(spsc_msg_ring_t *ring);
+
+int spsc_msg_ring_set_lazy(spsc_msg_ring_t *ring, uint32_t tail_batch, uint64_t flush_after_ns);
+
+int spsc_msg_ring_flush(spsc_msg_ring_t *ring);
+
+int spsc_msg_ring_get_eventfd(spsc_msg_ring_t *ring);
+
+int spsc_msg_ring_eventfd_drain(spsc_msg_ring_t *ring);
+
+void spsc_msg_ring_destroy(spsc_msg_ring_t **ring);
+
+#endif // SPSC_MSG_RING_H
@@ -1,12 +1,128 @@
 #ifndef SPSC_RING_H
 #define SPSC_RING_H
 
+#include <stddef.h>
 #include <stdint.h>
+#include <time.h>
+
+/*
+ * Granularity used to keep producer-owned, consumer-owned and read-mostly
+ * ring state apart. 64 bytes matches every x86-64 and most AArch64 parts; it
+ * can be overridden at build time (e.g. -DSPSC_RING_CACHE_LINE=128 for cores
+ * whose adjacent-line prefetcher pulls cache lines in pairs).
+ */
+#ifndef SPSC_RING_CACHE_LINE
+#define SPSC_RING_CACHE_LINE 64
+#endif
+
+/*
+ * Flags for spsc_ring_init_ex().
+ */
+#define SPSC_RING_BLOCKING   (1u << 0)   /* Enable spsc_ring_pop_wait()/spsc_ring_push_wait() */
+#define SPSC_RING_EVENTFD    (1u << 1)   /* Own an eventfd signalled when data arrives */
+#define SPSC_RING_MAGIC      (1u << 2)   /* Map the slots twice: spans never wrap */
+#define SPSC_RING_HUGEPAGE   (1u << 3)   /* Back the ring with huge pages, falling back to THP */
+#define SPSC_RING_POPULATE   (1u << 4)   /* Prefault every page at init */
+#define SPSC_RING_MLOCK      (1u << 5)   /* Lock the ring's pages in memory */
+#define SPSC_RING_SENTINEL   (1u << 6)   /* Mark free slots in place, never share head/tail */
+#define SPSC_RING_PAGE_FLAGS (SPSC_RING_HUGEPAGE | SPSC_RING_POPULATE | SPSC_RING_MLOCK)
+#define SPSC_RING_FLAGS_ALL  (SPSC_RING_BLOCKING | SPSC_RING_EVENTFD | SPSC_RING_MAGIC | \
+                              SPSC_RING_PAGE_FLAGS | SPSC_RING_SENTINEL)
+
+/*
+ * Content of a free slot in a SPSC_RING_SENTINEL ring. Never a valid fd,
+ * so it is the one value such a ring cannot carry.
+ */
+#define SPSC_RING_EMPTY_SLOT (-1)
+
+/*
+ * Placement policies for spsc_ring_init_numa_ex(): which node's memory
+ * backs the ring.
+ */
+#define SPSC_RING_NUMA_CONSUMER   0u   /* Consumer's node (spsc_ring_init_numa()) */
+#define SPSC_RING_NUMA_PRODUCER   1u   /* Producer's node */
+#define SPSC_RING_NUMA_INTERLEAVE 2u   /* Pages alternate between both nodes */
+
+/*
+ * Sides of a ring, for spsc_ring_shm_claim(), the liveness calls and the
+ * endpoint handles.
+ */
+#define SPSC_RING_SIDE_PRODUCER 0u
+#define SPSC_RING_SIDE_CONSUMER 1u
+
+/*
+ * Default number of spin iterations the blocking calls make before they
+ * park on the futex (see spsc_ring_set_spin()).
+ */
+#ifndef SPSC_RING_DEFAULT_SPIN
+#define SPSC_RING_DEFAULT_SPIN 1024u
+#endif
 
 typedef struct spsc_ring spsc_ring_t;
 
+/*
+ * Endpoint handles (spsc_ring_open_producer() / spsc_ring_open_consumer()):
+ * one side of a ring, owned by one thread, with that side's private state
+ * on its own cache line.
+ */
+typedef struct spsc_ring_producer spsc_ring_producer_t;
+
+typedef struct spsc_ring_consumer spsc_ring_consumer_t;
+
+/*
+ * Copy function with memcpy()'s signature: spsc_ring_copy(),
+ * spsc_ring_copy_stream() and memcpy() itself all fit the copy hooks of
+ * typed rings (<name>_set_copy()).
+ */
+typedef void *(*spsc_ring_copy_fn)(void *restrict dst, const void *restrict src, size_t bytes);
+
+typedef struct spsc_ring_span {
+    int      *data;
+    uint32_t  len;
+} spsc_ring_span_t;
+
+typedef struct spsc_ring_cspan {
+    const int *data;
+    uint32_t   len;
+} spsc_ring_cspan_t;
+
 spsc_ring_t *spsc_ring_init(uint32_t capacity);
 
+spsc_ring_t *spsc_ring_init_ex(uint32_t capacity, uint32_t flags);
+
+size_t spsc_ring_required_size(uint32_t capacity);
+
+spsc_ring_t *spsc_ring_init_in(void *mem, size_t bytes, uint32_t capacity);
+
+spsc_ring_t *spsc_ring_init_in_ex(void *mem, size_t bytes, uint32_t capacity, uint32_t flags);
+
+spsc_ring_t *spsc_ring_init_numa(uint32_t capacity, int producer_cpu, int consumer_cpu);
+
+spsc_ring_t *spsc_ring_init_numa_ex(uint32_t capacity, int producer_cpu, int consumer_cpu,
+                                    uint32_t flags, uint32_t placement);
+
+spsc_ring_t *spsc_ring_create_shm(const char *name, uint32_t capacity);
+
+spsc_ring_t *spsc_ring_create_shm_ex(const char *name, uint32_t capacity, uint32_t flags);
+
+spsc_ring_t *spsc_ring_attach_shm(const char *name);
+
+int spsc_ring_unlink_shm(const char *name);
+
+int spsc_ring_shm_claim(spsc_ring_t *ring, uint32_t side);
+
+int spsc_ring_shm_heartbeat(spsc_ring_t *ring, uint32_t side);
+
+int spsc_ring_peer_alive(spsc_ring_t *ring, uint32_t side);
+
+uint64_t spsc_ring_peer_epoch(spsc_ring_t *ring, uint32_t side);
+
+spsc_ring_t *spsc_ring_open_file(const char *path, uint32_t capacity);
+
+int spsc_ring_checkpoint(spsc_ring_t *ring);
+
+int spsc_ring_checkpoint_every(spsc_ring_t *ring, uint64_t interval_ns);
+
 int spsc_ring_push(spsc_ring_t *ring, int fd);
 
 int spsc_ring_pop(spsc_ring_t *ring, int *out_fd);
@@ -15,6 +131,104 @@ int spsc_ring_is_empty(spsc_ring_t *ring);
 
 int spsc_ring_is_full(spsc_ring_t *ring);
 
+uint32_t spsc_ring_push_bulk(spsc_ring_t *ring, const int *src, uint32_t n);
+
+int spsc_ring_push_bulk_all(spsc_ring_t *ring, const int *src, uint32_t n);
+
+uint32_t spsc_ring_pop_bulk(spsc_ring_t *ring, int *dst, uint32_t n);
+
+int spsc_ring_pop_bulk_all(spsc_ring_t *ring, int *dst, uint32_t n);
+
+uint32_t spsc_ring_reserve(spsc_ring_t *ring, uint32_t n,
+                           spsc_ring_span_t *first, spsc_ring_span_t *second);
+
+int spsc_ring_commit(spsc_ring_t *ring, uint32_t n);
+
+uint32_t spsc_ring_peek(spsc_ring_t *ring, uint32_t max,
+                        spsc_ring_cspan_t *first, spsc_ring_cspan_t *second);
+
+int spsc_ring_release(spsc_ring_t *ring, uint32_t n);
+
+int spsc_ring_set_spin(spsc_ring_t *ring, uint32_t spins);
+
+int spsc_ring_set_lazy(spsc_ring_t *ring, uint32_t tail_batch, uint64_t flush_after_ns);
+
+int spsc_ring_flush(spsc_ring_t *ring);
+
+int spsc_ring_set_probe(spsc_ring_t *ring, uint32_t batch);
+
+int spsc_ring_set_prefetch(spsc_ring_t *ring, uint32_t distance);
+
+int spsc_ring_set_stream(spsc_ring_t *ring, uint32_t min_bytes);
+
+void *spsc_ring_copy(void *restrict dst, const void *restrict src, size_t bytes);
+
+void *spsc_ring_copy_stream(void *restrict dst, const void *restrict src, size_t bytes);
+
+const char *spsc_ring_copy_kernel(void);
+
+int spsc_ring_copy_select(const char *name);
+
+spsc_ring_producer_t *spsc_ring_open_producer(spsc_ring_t *ring);
+
+spsc_ring_consumer_t *spsc_ring_open_consumer(spsc_ring_t *ring);
+
+void spsc_ring_close_producer(spsc_ring_producer_t **prod);
+
+void spsc_ring_close_consumer(spsc_ring_consumer_t **cons);
+
+int spsc_ring_producer_push(spsc_ring_producer_t *prod, int fd);
+
+uint32_t spsc_ring_producer_push_bulk(spsc_ring_producer_t *prod, const int *src, uint32_t n);
+
+int spsc_ring_producer_push_bulk_all(spsc_ring_producer_t *prod, const int *src, uint32_t n);
+
+uint32_t spsc_ring_producer_reserve(spsc_ring_producer_t *prod, uint32_t n,
+                                    spsc_ring_span_t *first, spsc_ring_span_t *second);
+
+int spsc_ring_producer_commit(spsc_ring_producer_t *prod, uint32_t n);
+
+int spsc_ring_producer_is_full(spsc_ring_producer_t *prod);
+
+int spsc_ring_producer_flush(spsc_ring_producer_t *prod);
+
+int spsc_ring_producer_push_wait(spsc_ring_producer_t *prod, int fd, int64_t timeout_ns);
+
+int spsc_ring_producer_push_wait_until(spsc_ring_producer_t *prod, int fd,
+                                       const struct timespec *deadline);
+
+int spsc_ring_consumer_pop(spsc_ring_consumer_t *cons, int *out_fd);
+
+uint32_t spsc_ring_consumer_pop_bulk(spsc_ring_consumer_t *cons, int *dst, uint32_t n);
+
+int spsc_ring_consumer_pop_bulk_all(spsc_ring_consumer_t *cons, int *dst, uint32_t n);
+
+uint32_t spsc_ring_consumer_peek(spsc_ring_consumer_t *cons, uint32_t max,
+                                 spsc_ring_cspan_t *first, spsc_ring_cspan_t *second);
+
+int spsc_ring_consumer_release(spsc_ring_consumer_t *cons, uint32_t n);
+
+int spsc_ring_consumer_is_empty(spsc_ring_consumer_t *cons);
+
+int spsc_ring_consumer_pop_wait(spsc_ring_consumer_t *cons, int *out_fd, int64_t timeout_ns);
+
+int spsc_ring_consumer_pop_wait_until(spsc_ring_consumer_t *cons, int *out_fd,
+                                      const struct timespec *deadline);
+
+int spsc_ring_consumer_eventfd_drain(spsc_ring_consumer_t *cons);
+
+int spsc_ring_get_eventfd(spsc_ring_t *ring);
+
+int spsc_ring_eventfd_drain(spsc_ring_t *ring);
+
+int spsc_ring_push_wait(spsc_ring_t *ring, int fd, int64_t timeout_ns);
+
+int spsc_ring_pop_wait(spsc_ring_t *ring, int *out_fd, int64_t timeout_ns);
+
+int spsc_ring_push_wait_until(spsc_ring_t *ring, int fd, const struct timespec *deadline);
+
+int spsc_ring_pop_wait_until(spsc_ring_t *ring, int *out_fd, const struct timespec *deadline);
+
 void spsc_ring_destroy(spsc_ring_t **ring);
 
 #endif // SPSC_RING_H
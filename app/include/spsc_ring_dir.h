@@ -0,0 +1,30 @@
+#ifndef SPSC_RING_DIR_H
+#define SPSC_RING_DIR_H
+
+#include <stdint.h>
+
+#include "spsc_ring.h"
+
+/* Longest ring name stored in a directory, including the terminating NUL */
+#define SPSC_RING_DIR_NAME_MAX 48u
+
+typedef struct spsc_ring_dir spsc_ring_dir_t;
+
+typedef struct spsc_ring_dir_spec {
+    const char *name;       /* Unique within the directory */
+    uint32_t    capacity;   /* Power of 2 */
+    uint32_t    flags;      /* 0 or SPSC_RING_BLOCKING */
+} spsc_ring_dir_spec_t;
+
+spsc_ring_dir_t *spsc_ring_dir_create(const char *shm_name,
+                                      const spsc_ring_dir_spec_t *specs, uint32_t count);
+
+spsc_ring_dir_t *spsc_ring_dir_attach(const char *shm_name);
+
+spsc_ring_t *spsc_ring_dir_lookup(spsc_ring_dir_t *dir, const char *name);
+
+uint32_t spsc_ring_dir_count(spsc_ring_dir_t *dir);
+
+void spsc_ring_dir_destroy(spsc_ring_dir_t **dir);
+
+#endif // SPSC_RING_DIR_H
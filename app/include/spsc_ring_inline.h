@@ -0,0 +1,926 @@
+#ifndef SPSC_RING_INLINE_H
+#define SPSC_RING_INLINE_H
+
+/*
+ * SPSC Ring Buffer - Inline Hot Path
+ * ==================================
+ * 
+ * Opt-in header that exposes the layout of struct spsc_ring together with
+ * static inline versions of the per-element hot path:
+ * 
+ *   spsc_ring_push_inline()     spsc_ring_pop_inline()
+ *   spsc_ring_is_full_inline()  spsc_ring_is_empty_inline()
+ *   spsc_ring_producer_push_inline()  spsc_ring_consumer_pop_inline()
+ * 
+ * spsc_ring.h on its own keeps spsc_ring_t opaque, so every push/pop is an
+ * out-of-line call (through the PLT when linking spsc_ring_shared). Code
+ * that includes this header instead gets the operations inlined into its
+ * own loop, where the compiler can keep the slot base/cfg.mask in registers
+ * across iterations. Ring creation and destruction, and everything else,
+ * still go through the library.
+ * 
+ * The library's exported spsc_ring_push()/spsc_ring_pop()/... are thin
+ * wrappers around these functions, so both paths run exactly the same
+ * algorithm and may be mixed freely on the same ring.
+ * 
+ * Trade-off: code built against this header depends on the structure
+ * layout, so it must be rebuilt whenever the library's layout changes.
+ * Users who need a stable ABI should keep to spsc_ring.h.
+ * 
+ * Unlike the exported functions, the inline versions do not check for a
+ * NULL ring.
+ */
+
+#include <stdatomic.h>   /* C11 atomic operations and memory ordering */
+#include <stddef.h>      /* size_t */
+#include <stdint.h>      /* uint32_t, uint64_t */
+#include <string.h>      /* memcpy */
+
+#include "spsc_ring.h"
+#include "spsc_ring_prefetch.h"
+
+/*
+ * SPSC Ring Buffer Structure
+ * ==========================
+ * 
+ * The ring buffer uses a circular array with head and tail indices.
+ * head and tail are free-running 64-bit counters: they are never wrapped
+ * themselves, only masked when used to address a slot. tail - head is always
+ * the exact number of stored elements, so full (tail - head == size) and
+ * empty (tail == head) are distinct and all size slots are usable. At
+ * billions of operations per second a 64-bit counter takes centuries to
+ * wrap, so overflow never has to be reasoned about.
+ * 
+ * Memory Layout:
+ * The structure is split into separate cache lines so that the producer and
+ * consumer never write to a line the other side is reading on its fast path:
+ * 
+ * - cfg  (read-mostly, written once by spsc_ring_init)
+ *     buf_off: Byte offset of the slot array from the ring structure
+ *              itself. An offset rather than a pointer keeps the structure
+ *              position-independent, so a ring placed in shared memory
+ *              works at whatever address each process maps it
+ *              (see spsc_ring_buf())
+ *     size:  Total capacity (must be power of 2 for efficient masking)
+ *     mask:  Bitmask for wrapping indices (size - 1)
+ *     flags: SPSC_RING_* flags given to spsc_ring_init_ex()
+ *     spin:  Spin budget of the blocking calls before they park
+ *     efd:   eventfd of SPSC_RING_EVENTFD rings, -1 otherwise
+ *     map_fd: Backing file of file-backed rings (holds their lock), -1
+ *             otherwise
+ *     storage: Where the ring lives (heap, shared memory, ...), used by
+ *              spsc_ring_destroy() to release it the right way
+ *     probe: How far ahead a SPSC_RING_SENTINEL ring looks for free or
+ *            filled slots (see spsc_ring_set_probe()), 1 by default
+ *     map_bytes: Length of the mapping of a page-backed heap ring
+ *     tail_batch, head_batch, lazy_ns: Deferred publication settings,
+ *              0 unless spsc_ring_set_lazy() turned it on
+ * 
+ * - prod (owned by the producer)
+ *     tail:        Published write position (atomic, read by the consumer)
+ *     local:       The producer's private state (spsc_ring_prod_local_t):
+ *       next:        Producer's own write position; equal to tail except
+ *                    while publication is deferred
+ *       cached_head: Producer's private copy of the consumer's head
+ *       reserved:    Slots handed out by spsc_ring_reserve() and not yet
+ *                    committed
+ *       prefetch:    Prefetch distance of the producer (see
+ *                    spsc_ring_prefetch_prod())
+ *       lazy_since:  When the oldest still unpublished element was written
+ *                    (ns), 0 if there is none
+ *       stream_min:  Bulk pushes this large use non-temporal stores (see
+ *                    spsc_ring_set_stream()), 0 if none do
+ * 
+ * - cons (owned by the consumer)
+ *     head:        Published read position (atomic, read by the producer)
+ *     local:       The consumer's private state (spsc_ring_cons_local_t):
+ *       next:        Consumer's own read position; equal to head except
+ *                    while publication is deferred
+ *       cached_tail: Consumer's private copy of the producer's tail
+ *       prefetch:    Prefetch distance of the consumer
+ *     durable:     Head of the last durable checkpoint of a file-backed
+ *                  ring (SPSC_RING_DURABLE), unused otherwise
+ * 
+ * - wait (SPSC_RING_BLOCKING / SPSC_RING_EVENTFD rings, written only
+ *   around sleeping)
+ *     cons_waiting: Futex word, 1 while the consumer is parked in
+ *                   spsc_ring_pop_wait() or idle waiting for the eventfd
+ *                   (read by the producer)
+ *     prod_waiting: Futex word, 1 while the producer is parked in
+ *                   spsc_ring_push_wait() (read by the consumer)
+ *     endpoints:    Bit 1 << SPSC_RING_SIDE_* set while that side has an
+ *                   open endpoint handle, so a second
+ *                   spsc_ring_open_producer() fails instead of sharing it
+ *   Kept off the index lines: after every publish the other side reads its
+ *   flag, and a line that is only ever read stays shared in both caches.
+ * 
+ * Cached Opposite Index:
+ * Each side checks full/empty against its private copy of the other side's
+ * index first. The shared atomic is only reloaded (with acquire ordering)
+ * when that stale copy says the ring looks full (producer) or empty
+ * (consumer). Since the real head only ever moves towards tail and vice
+ * versa, a stale copy can only under-estimate the available room/items,
+ * never over-estimate it, so skipping the reload is always safe.
+ * 
+ * Invariants:
+ * - size is always a power of 2
+ * - mask = size - 1
+ * - head <= cons next <= tail <= prod next
+ * - 0 <= prod next - head <= size
+ * - Slot of index i is spsc_ring_buf(ring)[i & mask]
+ * - Buffer is empty when: head == tail
+ * - Buffer is full when: tail - head == size
+ * 
+ * SPSC_RING_SENTINEL rings never store head or tail at all (see
+ * spsc_ring_sentinel_room()); only next and the cached copies move.
+ * 
+ * Private Side State:
+ * Everything a side keeps to itself is grouped in prod.local / cons.local,
+ * and every helper below works on such a block passed in as ps / cs rather
+ * than on the ring's own copy. The ring-level calls pass the ring's copy;
+ * an endpoint handle (spsc_ring_open_producer() / spsc_ring_open_consumer())
+ * takes the block over and keeps it in its own cache-line aligned
+ * allocation, owned by one thread, until it is closed.
+ */
+typedef struct spsc_ring_prod_local {
+    uint64_t   next;           /* Producer's own write index, >= tail */
+    uint64_t   cached_head;    /* Last head value observed by the producer */
+    uint32_t   reserved;       /* Outstanding spsc_ring_reserve() slots */
+    uint32_t   prefetch;       /* Slots ahead to prefetch for writing, 0 = off */
+    uint64_t   lazy_since;     /* Time of the oldest unpublished element, 0 if none */
+    uint32_t   stream_min;     /* Bulk pushes of at least this many bytes stream, 0 = never */
+} spsc_ring_prod_local_t;
+
+typedef struct spsc_ring_cons_local {
+    uint64_t   next;           /* Consumer's own read index, >= head */
+    uint64_t   cached_tail;    /* Last tail value observed by the consumer */
+    uint32_t   prefetch;       /* Slots ahead to prefetch for reading, 0 = off */
+} spsc_ring_cons_local_t;
+
+/*
+ * Library-internal cfg.flags bit, never accepted from callers: set on
+ * file-backed rings (spsc_ring_open_file()). Their producer may only
+ * reuse slots behind the head of the last durable checkpoint
+ * (cons.durable), not behind the live head, so a crash can never leave
+ * the checkpointed window overwritten (see spsc_ring_checkpoint()).
+ */
+#define SPSC_RING_DURABLE (1u << 31)
+
+struct spsc_ring{
+    struct {
+        int64_t    buf_off;        /* Slot array offset from the ring, in bytes */
+        uint32_t   size, mask;     /* Size must be power of two; mask = size−1 for fast modulo */
+        uint32_t   flags;          /* SPSC_RING_* flags */
+        uint32_t   spin;           /* Spin iterations before a blocking call parks */
+        int        efd;            /* eventfd for SPSC_RING_EVENTFD rings, else -1 */
+        int        map_fd;         /* Backing file of file-backed rings, else -1 */
+        uint32_t   storage;        /* How spsc_ring_destroy() releases the ring */
+        uint32_t   probe;          /* Slots probed ahead by a sentinel ring, 1 = one */
+        uint64_t   map_bytes;      /* Mapped length of a page-backed heap ring, else 0 */
+        uint32_t   tail_batch;     /* Publish tail every tail_batch elements, 0 = always */
+        uint32_t   head_batch;     /* Publish head every head_batch elements, 0 = always */
+        uint64_t   lazy_ns;        /* Age at which a push publishes, 0 = no time check */
+    } cfg;
+
+    _Alignas(SPSC_RING_CACHE_LINE) struct {
+        _Atomic uint64_t tail;     /* Producer's write index (atomically updated) */
+        spsc_ring_prod_local_t local;  /* Producer's private state */
+    } prod;
+
+    _Alignas(SPSC_RING_CACHE_LINE) struct {
+        _Atomic uint64_t head;     /* Consumer's read index (atomically updated) */
+        spsc_ring_cons_local_t local;  /* Consumer's private state */
+        _Atomic uint64_t durable;  /* Checkpointed head, SPSC_RING_DURABLE rings only */
+    } cons;
+
+    _Alignas(SPSC_RING_CACHE_LINE) struct {
+        _Atomic uint32_t cons_waiting;  /* Consumer parked on this futex word */
+        _Atomic uint32_t prod_waiting;  /* Producer parked on this futex word */
+        _Atomic uint32_t endpoints;     /* Bit 1 << SPSC_RING_SIDE_* per open handle */
+    } wait;
+};
+
+/*
+ * Caller-Provided Storage
+ * =======================
+ * 
+ * SPSC_RING_REQUIRED_SIZE() is the compile-time form of
+ * spsc_ring_required_size(): the bytes spsc_ring_init_in() needs for a
+ * ring of capacity slots (structure, then slots). The memory must be
+ * aligned to SPSC_RING_CACHE_LINE, e.g. inside a caller's own struct:
+ * 
+ *   _Alignas(SPSC_RING_CACHE_LINE) unsigned char rx[SPSC_RING_REQUIRED_SIZE(256)];
+ * 
+ * SPSC_RING_DECLARE_STATIC() declares such a block with static storage
+ * duration (zero-initialised, so it lands in .bss) and rejects a capacity
+ * that is not a power of 2 at compile time:
+ * 
+ *   SPSC_RING_DECLARE_STATIC(rx_mem, 256);
+ *   spsc_ring_t *rx = spsc_ring_init_in(rx_mem, sizeof(rx_mem), 256);
+ */
+#define SPSC_RING_REQUIRED_SIZE(capacity) \
+    (sizeof(spsc_ring_t) + (size_t)(capacity) * sizeof(int))
+
+#define SPSC_RING_DECLARE_STATIC(name, capacity)                                    \
+    _Static_assert((capacity) != 0 && ((capacity) & ((capacity) - 1)) == 0,         \
+                   "SPSC_RING_DECLARE_STATIC: capacity must be a power of 2");      \
+    static _Alignas(SPSC_RING_CACHE_LINE) unsigned char name[SPSC_RING_REQUIRED_SIZE(capacity)]
+
+/*
+ * Slot Array Address
+ * ==================
+ * 
+ * Resolves cfg.buf_off against this process's address of the ring. One
+ * add on a line the hot path reads anyway, so it costs the same as the
+ * plain pointer it replaces.
+ */
+static inline int *spsc_ring_buf(spsc_ring_t *ring)
+{
+    return (int *)(intptr_t)((intptr_t)ring + (intptr_t)ring->cfg.buf_off);
+}
+
+/*
+ * Library Slow Paths (internal)
+ * =============================
+ * 
+ * Out-of-line helpers the inline fast paths below call into: the wake-ups
+ * and the eventfd arming (spsc_ring_wait.c), only reached after seeing the
+ * peer's waiting flag set, and the deferred-publication age check
+ * (spsc_ring.c). They have to be exported because the inline code that
+ * calls them is compiled into the application, but they are not API: the
+ * double underscore marks them as internal, and their names and signatures
+ * change with the ring layout. Do not call them directly.
+ */
+void spsc_ring__wake_consumer(spsc_ring_t *ring);
+
+void spsc_ring__wake_producer(spsc_ring_t *ring);
+
+uint32_t spsc_ring__arm_eventfd(spsc_ring_t *ring, spsc_ring_cons_local_t *cs, uint64_t h);
+
+int spsc_ring__lazy_expired(spsc_ring_t *ring, spsc_ring_prod_local_t *ps);
+
+static inline void spsc_ring_store_tail(spsc_ring_t *ring, uint64_t t);
+
+static inline void spsc_ring_store_head(spsc_ring_t *ring, uint64_t h);
+
+/*
+ * Free Slot / Ready Element Counts
+ * ================================
+ * 
+ * Shared by the single-element and bulk paths so that every operation
+ * follows the same cached-index rule: compute the answer from this side's
+ * private copy of the opposite index and reload the shared atomic (acquire)
+ * only if that copy cannot satisfy the request.
+ * 
+ * (tail - head) is the exact number of stored elements, so the producer
+ * can use all size slots.
+ * 
+ * - spsc_ring_prod_room():  free slots seen by the producer at tail t
+ * - spsc_ring_cons_ready(): readable elements seen by the consumer at head h
+ * 
+ * On SPSC_RING_EVENTFD rings, a consumer that finds the ring empty also
+ * declares itself idle here (spsc_ring__arm_eventfd()), so every consumer
+ * path - pop, bulk pop, peek, is_empty - arms the eventfd on the
+ * non-empty -> empty transition without the caller doing anything.
+ * 
+ * Under deferred publication (spsc_ring_set_lazy()) a side that comes up
+ * short also publishes its own pending index here: a full producer hands
+ * its unpublished elements over, an empty consumer hands its unreturned
+ * slots back, so neither side can wait on the other's deferred index.
+ * 
+ * Both return a value that is >= want whenever the real ring can satisfy
+ * want, and may return less (never more) than the real amount otherwise.
+ */
+static inline uint32_t spsc_ring_prod_room(spsc_ring_t *ring, spsc_ring_prod_local_t *ps, uint64_t t, uint32_t want)
+{
+    uint32_t room = ring->cfg.size - (uint32_t)(t - ps->cached_head);
+    if (room < want)
+    {
+        _Atomic uint64_t *head = (ring->cfg.flags & SPSC_RING_DURABLE) ? &ring->cons.durable
+                                                                       : &ring->cons.head;
+        ps->cached_head = atomic_load_explicit(head, memory_order_acquire);
+        room = ring->cfg.size - (uint32_t)(t - ps->cached_head);
+        if (room < want && ring->cfg.tail_batch != 0 &&
+            atomic_load_explicit(&ring->prod.tail, memory_order_relaxed) != t)
+        {
+            ps->lazy_since = 0;
+            spsc_ring_store_tail(ring, t);
+        }
+    }
+    return room;
+}
+
+static inline uint32_t spsc_ring_cons_ready(spsc_ring_t *ring, spsc_ring_cons_local_t *cs, uint64_t h, uint32_t want)
+{
+    uint32_t ready = (uint32_t)(cs->cached_tail - h);
+    if (ready < want)
+    {
+        cs->cached_tail = atomic_load_explicit(&ring->prod.tail, memory_order_acquire);
+        ready = (uint32_t)(cs->cached_tail - h);
+        if (ready < want && ring->cfg.head_batch != 0 &&
+            atomic_load_explicit(&ring->cons.head, memory_order_relaxed) != h)
+        {
+            spsc_ring_store_head(ring, h);
+        }
+        if (ready == 0 && (ring->cfg.flags & SPSC_RING_EVENTFD))
+        {
+            ready = spsc_ring__arm_eventfd(ring, cs, h);
+        }
+    }
+    return ready;
+}
+
+/*
+ * Index Publication
+ * =================
+ * 
+ * Every place that makes new elements visible (tail) or hands slots back
+ * (head) goes through these helpers, so the release store and the wake-up
+ * protocol of SPSC_RING_BLOCKING rings live in one place.
+ * 
+ * Wake-up protocol (Dekker style, no lost wake-ups):
+ * 
+ *   publisher                         waiter
+ *   ---------                         ------
+ *   store index (release)             store waiting = 1
+ *   fence (seq_cst)                   fence (seq_cst)
+ *   load waiting                      load index, sleep only if no progress
+ * 
+ * With both fences at least one side sees the other's store: either the
+ * waiter sees the new index and does not sleep, or the publisher sees the
+ * flag and issues the futex wake. On rings created without
+ * SPSC_RING_BLOCKING the whole block is skipped on a single predictable
+ * branch, so the non-blocking hot path stays fence- and syscall-free; on
+ * blocking rings the syscall is still only made when the peer really
+ * sleeps.
+ * 
+ * SPSC_RING_EVENTFD rings use the same consumer flag: it is set while the
+ * consumer is idle in its epoll loop, and the producer writes the eventfd
+ * only for the publish that finds it set (the empty -> non-empty edge),
+ * not once per element.
+ * 
+ * Deferred Publication:
+ * spsc_ring_publish_tail()/spsc_ring_publish_head() always advance the
+ * side's own index (ps->next / cs->next). With spsc_ring_set_lazy() in
+ * force they only store the shared index - and only then pay the release
+ * store, the fence and the line transfer to the other core - once
+ * tail_batch / head_batch elements are pending or (producer) a push finds
+ * the oldest pending element older than lazy_ns; spsc_ring_store_tail() /
+ * spsc_ring_store_head() are the unconditional stores. Rings without lazy
+ * publication take the store on one predictable branch, as before.
+ * 
+ * The age is looked at by the push that starts a batch and then by every
+ * push that takes the pending count to or past a multiple of
+ * SPSC_RING_LAZY_STRIDE, i.e. tail_batch / SPSC_RING_LAZY_STRIDE + 1 clock
+ * reads per batch rather than one per element. The tail is thus published
+ * within lazy_ns or SPSC_RING_LAZY_STRIDE further elements, whichever
+ * comes later.
+ */
+#ifndef SPSC_RING_LAZY_STRIDE
+#define SPSC_RING_LAZY_STRIDE 8u   /* Power of two */
+#endif
+
+static inline int spsc_ring_defer_tail(spsc_ring_t *ring, spsc_ring_prod_local_t *ps,
+                                       uint64_t prev, uint64_t t)
+{
+    uint64_t pub     = atomic_load_explicit(&ring->prod.tail, memory_order_relaxed);
+    uint64_t pending = t - pub;
+    if (pending >= ring->cfg.tail_batch)
+    {
+        return 0;
+    }
+    if (ring->cfg.lazy_ns == 0)
+    {
+        return 1;
+    }
+
+    /* Clock only on the first element and on each stride boundary. */
+    uint64_t before = prev - pub;
+    uint64_t stride = ~(uint64_t)(SPSC_RING_LAZY_STRIDE - 1);
+    if (before != 0 && (before & stride) == (pending & stride))
+    {
+        return 1;
+    }
+    return !spsc_ring__lazy_expired(ring, ps);
+}
+
+static inline void spsc_ring_publish_tail(spsc_ring_t *ring, spsc_ring_prod_local_t *ps, uint64_t t)
+{
+    uint64_t prev = ps->next;
+    ps->next = t;
+    if (ring->cfg.tail_batch != 0)
+    {
+        if (spsc_ring_defer_tail(ring, ps, prev, t))
+        {
+            return;
+        }
+        ps->lazy_since = 0;
+    }
+    spsc_ring_store_tail(ring, t);
+}
+
+static inline void spsc_ring_publish_head(spsc_ring_t *ring, spsc_ring_cons_local_t *cs, uint64_t h)
+{
+    cs->next = h;
+    if (ring->cfg.head_batch != 0 &&
+        h - atomic_load_explicit(&ring->cons.head, memory_order_relaxed) < ring->cfg.head_batch)
+    {
+        return;
+    }
+    spsc_ring_store_head(ring, h);
+}
+
+static inline void spsc_ring_store_tail(spsc_ring_t *ring, uint64_t t)
+{
+    atomic_store_explicit(&ring->prod.tail, t, memory_order_release);
+
+    if (ring->cfg.flags & (SPSC_RING_BLOCKING | SPSC_RING_EVENTFD))
+    {
+        atomic_thread_fence(memory_order_seq_cst);
+        if (atomic_load_explicit(&ring->wait.cons_waiting, memory_order_relaxed))
+        {
+            spsc_ring__wake_consumer(ring);
+        }
+    }
+}
+
+static inline void spsc_ring_store_head(spsc_ring_t *ring, uint64_t h)
+{
+    atomic_store_explicit(&ring->cons.head, h, memory_order_release);
+
+    if (ring->cfg.flags & SPSC_RING_BLOCKING)
+    {
+        atomic_thread_fence(memory_order_seq_cst);
+        if (atomic_load_explicit(&ring->wait.prod_waiting, memory_order_relaxed))
+        {
+            spsc_ring__wake_producer(ring);
+        }
+    }
+}
+
+/*
+ * Wrap-Aware Slot Copies
+ * ======================
+ * 
+ * Copy n elements into / out of the ring starting at a free-running index.
+ * A run that crosses the end of buf is split into at most two contiguous
+ * memcpy() segments: [idx, size) and [0, n - first).
+ * 
+ * On SPSC_RING_MAGIC rings the slots are mapped a second time right after
+ * the first copy, so the whole run is always contiguous from slot idx and
+ * spsc_ring_first_run() never splits it.
+ * 
+ * A push of at least ps->stream_min bytes is copied with
+ * spsc_ring_copy_stream() (non-temporal stores, see spsc_ring_copy.c)
+ * instead of memcpy().
+ * 
+ * The caller must already have checked that n slots are free / readable.
+ */
+static inline uint32_t spsc_ring_first_run(const spsc_ring_t *ring, uint32_t idx, uint32_t n)
+{
+    uint32_t to_end = ring->cfg.size - idx;
+    return (n <= to_end || (ring->cfg.flags & SPSC_RING_MAGIC)) ? n : to_end;
+}
+
+static inline void spsc_ring_copy_in(spsc_ring_t *ring, const spsc_ring_prod_local_t *ps,
+                                     uint64_t t, const int *src, uint32_t n)
+{
+    uint32_t idx   = (uint32_t)(t & ring->cfg.mask);
+    uint32_t first = spsc_ring_first_run(ring, idx, n);
+
+    int *buf = spsc_ring_buf(ring);
+    if (ps->stream_min != 0 && n * sizeof(int) >= ps->stream_min)
+    {
+        spsc_ring_copy_stream(&buf[idx], src, first * sizeof(int));
+        spsc_ring_copy_stream(buf, src + first, (n - first) * sizeof(int));
+        return;
+    }
+    memcpy(&buf[idx], src, first * sizeof(int));
+    memcpy(buf, src + first, (n - first) * sizeof(int));
+}
+
+static inline void spsc_ring_copy_out(spsc_ring_t *ring, uint64_t h, int *dst, uint32_t n)
+{
+    uint32_t idx   = (uint32_t)(h & ring->cfg.mask);
+    uint32_t first = spsc_ring_first_run(ring, idx, n);
+
+    const int *buf = spsc_ring_buf(ring);
+    memcpy(dst, &buf[idx], first * sizeof(int));
+    memcpy(dst + first, buf, (n - first) * sizeof(int));
+}
+
+/*
+ * Slot Prefetch
+ * =============
+ * 
+ * With a prefetch distance d (spsc_ring_set_prefetch()), a side that has
+ * just written / read slots [i, i + n) hints the slots [i + d, i + d + n),
+ * so the line it will need d elements from now is on its way while it
+ * works on the current ones. Only the lines that start inside that window
+ * are hinted, i.e. one hint per cache line of slots, not one per call.
+ * 
+ * - Producer: write-intent prefetch, which fetches the line in exclusive
+ *   state and saves the later invalidation round trip
+ * - Consumer: read prefetch
+ * 
+ * Each side only prefetches slots it already knows the other side is done
+ * with (below cached_head + size / cached_tail): pulling a line the peer
+ * is still writing or reading away from it would add a transfer instead
+ * of hiding one. The stale cached index only makes that bound
+ * conservative.
+ */
+static inline void spsc_ring_prefetch_slots(spsc_ring_t *ring, uint64_t from, uint64_t end,
+                                            uint32_t n, int write)
+{
+    if (from >= end) return;
+    if (n > end - from) n = (uint32_t)(end - from);
+
+    uint32_t idx   = (uint32_t)(from & ring->cfg.mask);
+    uint32_t first = spsc_ring_first_run(ring, idx, n);
+    int     *buf   = spsc_ring_buf(ring);
+    spsc_ring_prefetch_lines(&buf[idx], first * sizeof(int), write);
+    if (n > first)
+    {
+        spsc_ring_prefetch_lines(buf, (n - first) * sizeof(int), write);
+    }
+}
+
+/* After writing [t, t + n) */
+static inline void spsc_ring_prefetch_prod(spsc_ring_t *ring, const spsc_ring_prod_local_t *ps,
+                                           uint64_t t, uint32_t n)
+{
+    if (ps->prefetch != 0)
+    {
+        spsc_ring_prefetch_slots(ring, t + ps->prefetch,
+                                 ps->cached_head + ring->cfg.size, n, 1);
+    }
+}
+
+/* After reading [h, h + n) */
+static inline void spsc_ring_prefetch_cons(spsc_ring_t *ring, const spsc_ring_cons_local_t *cs,
+                                           uint64_t h, uint32_t n)
+{
+    if (cs->prefetch != 0)
+    {
+        spsc_ring_prefetch_slots(ring, h + cs->prefetch, cs->cached_tail, n, 0);
+    }
+}
+
+/*
+ * Slot-Sentinel Mode (SPSC_RING_SENTINEL)
+ * =======================================
+ * 
+ * FastForward-style ring: a free slot holds SPSC_RING_EMPTY_SLOT, so the
+ * slot itself says whether it may be written (producer) or read
+ * (consumer). The producer only looks at the slot at ps->next and the
+ * consumer only at the slot at cs->next; neither ever loads or stores
+ * the shared head / tail, so the prod and cons lines stay private to their
+ * owner and the only lines that travel between the cores are the slots,
+ * which have to travel anyway.
+ * 
+ * - Push: release store of the value into the slot
+ * - Pop:  read the value, then release store of SPSC_RING_EMPTY_SLOT
+ * 
+ * Both sides still know what they saw last: cached_head / cached_tail hold
+ * the end of the run of slots the last probe proved free / filled, so a
+ * side that found k slots in one probe makes its next k - 1 calls without
+ * touching a slot the peer is writing.
+ * 
+ * Batched probing (B-Queue): with cfg.probe = 1 every call on a nearly
+ * empty ring reads the slot the peer has just written, and the line
+ * bounces once per element. With cfg.probe = b > 1 a side that runs out
+ * probes the slot b - 1 ahead first: since slots fill and drain strictly
+ * in order, finding it free (filled) proves the whole run of b free
+ * (filled). If it is not, the distance is halved until it drops below
+ * what the call needs. The consumer thus keeps off the producer's current
+ * line until a batch has built up behind it, and vice versa.
+ * 
+ * Slots are accessed as _Atomic int (same size and alignment as int on
+ * every target this library supports).
+ */
+static inline _Atomic int *spsc_ring_slot(spsc_ring_t *ring, uint64_t i)
+{
+    return (_Atomic int *)&spsc_ring_buf(ring)[i & ring->cfg.mask];
+}
+
+/*
+ * Free slots from t on as far as the producer knows, probing when fewer
+ * than want are known. hint is the distance the caller would like to
+ * probe (a bulk call passes its n).
+ */
+static inline uint32_t spsc_ring_sentinel_room(spsc_ring_t *ring, spsc_ring_prod_local_t *ps, uint64_t t,
+                                               uint32_t want, uint32_t hint)
+{
+    uint32_t room = ring->cfg.size - (uint32_t)(t - ps->cached_head);
+    if (room >= want)
+    {
+        return room;
+    }
+
+    uint32_t b = (hint > ring->cfg.probe) ? hint : ring->cfg.probe;
+    if (b > ring->cfg.size) b = ring->cfg.size;
+    for (; b >= want && b != 0; b >>= 1)
+    {
+        /* Acquire: pairs with the consumer's release of that slot */
+        if (atomic_load_explicit(spsc_ring_slot(ring, t + b - 1), memory_order_acquire) ==
+            SPSC_RING_EMPTY_SLOT)
+        {
+            ps->cached_head = t + b - ring->cfg.size;
+            return b;
+        }
+    }
+    return room;
+}
+
+/* Consumer-side mirror: filled slots from h on */
+static inline uint32_t spsc_ring_sentinel_ready(spsc_ring_t *ring, spsc_ring_cons_local_t *cs, uint64_t h,
+                                                uint32_t want, uint32_t hint)
+{
+    uint32_t ready = (uint32_t)(cs->cached_tail - h);
+    if (ready >= want)
+    {
+        return ready;
+    }
+
+    uint32_t b = (hint > ring->cfg.probe) ? hint : ring->cfg.probe;
+    if (b > ring->cfg.size) b = ring->cfg.size;
+    for (; b >= want && b != 0; b >>= 1)
+    {
+        /* Acquire: pairs with the producer's release of that slot */
+        if (atomic_load_explicit(spsc_ring_slot(ring, h + b - 1), memory_order_acquire) !=
+            SPSC_RING_EMPTY_SLOT)
+        {
+            cs->cached_tail = h + b;
+            return b;
+        }
+    }
+    return ready;
+}
+
+static inline int spsc_ring_push_sentinel(spsc_ring_t *ring, spsc_ring_prod_local_t *ps, int fd)
+{
+    uint64_t t = ps->next;
+    if (fd == SPSC_RING_EMPTY_SLOT || spsc_ring_sentinel_room(ring, ps, t, 1, 1) == 0)
+    {
+        return -1;  // Unstorable value, or buffer is full
+    }
+
+    /* The slot itself is the publication */
+    atomic_store_explicit(spsc_ring_slot(ring, t), fd, memory_order_release);
+    ps->next = t + 1;
+    spsc_ring_prefetch_prod(ring, ps, t, 1);
+    return 0;
+}
+
+static inline int spsc_ring_pop_sentinel(spsc_ring_t *ring, spsc_ring_cons_local_t *cs, int *out_fd)
+{
+    uint64_t h = cs->next;
+    if (spsc_ring_sentinel_ready(ring, cs, h, 1, 1) == 0)
+    {
+        return -1;  // Buffer is empty
+    }
+
+    /*
+     * The probe that proved this slot filled was an acquire load of it or
+     * of a later slot, so a relaxed read sees the producer's value
+     */
+    _Atomic int *slot = spsc_ring_slot(ring, h);
+    if (out_fd)
+    {
+        *out_fd = atomic_load_explicit(slot, memory_order_relaxed);
+    }
+
+    /* Hand the slot back: the read above is done before the producer reuses it */
+    atomic_store_explicit(slot, SPSC_RING_EMPTY_SLOT, memory_order_release);
+    cs->next = h + 1;
+    spsc_ring_prefetch_cons(ring, cs, h, 1);
+    return 0;
+}
+
+/*
+ * Inline Full / Empty Checks
+ * ==========================
+ * 
+ * See spsc_ring_is_full() / spsc_ring_is_empty(). Only the side that owns
+ * the cached index may call them: is_full from the producer, is_empty from
+ * the consumer.
+ */
+static inline int spsc_ring_is_full_local(spsc_ring_t *ring, spsc_ring_prod_local_t *ps)
+{
+    /*
+     * Load current write position (where we'll write next)
+     * A plain load: ps->next is private to the producer, and it runs
+     * ahead of the shared tail while publication is deferred
+     */
+    uint64_t t = ps->next;
+
+    if (ring->cfg.flags & SPSC_RING_SENTINEL)
+    {
+        return spsc_ring_sentinel_room(ring, ps, t, 1, 1) == 0;
+    }
+
+    /*
+     * Ask for a single slot: the shared head is only reloaded (acquire)
+     * when the cached head says there is no room left
+     */
+    return spsc_ring_prod_room(ring, ps, t, 1) == 0;
+}
+
+static inline int spsc_ring_is_empty_local(spsc_ring_t *ring, spsc_ring_cons_local_t *cs)
+{
+    /*
+     * Load current read position (where we'll read next)
+     * A plain load: cs->next is private to the consumer, and it runs
+     * ahead of the shared head while publication is deferred
+     */
+    uint64_t h = cs->next;
+
+    if (ring->cfg.flags & SPSC_RING_SENTINEL)
+    {
+        return spsc_ring_sentinel_ready(ring, cs, h, 1, 1) == 0;
+    }
+
+    /*
+     * Ask for a single element: the shared tail is only reloaded (acquire)
+     * when the cached tail says nothing is left to read
+     */
+    return spsc_ring_cons_ready(ring, cs, h, 1) == 0;
+}
+
+/*
+ * Inline Push (Producer Function)
+ * ===============================
+ * 
+ * See spsc_ring_push(). Returns 0 on success, -1 if the ring is full
+ * (or, on a SPSC_RING_SENTINEL ring, if fd is SPSC_RING_EMPTY_SLOT).
+ */
+static inline int spsc_ring_push_local(spsc_ring_t *ring, spsc_ring_prod_local_t *ps, int fd)
+{
+    if (ring->cfg.flags & SPSC_RING_SENTINEL)
+    {
+        return spsc_ring_push_sentinel(ring, ps, fd);
+    }
+
+    /*
+     * Load current write position (where we'll write next)
+     * A plain load: ps->next is private to the producer, and it runs
+     * ahead of the shared tail while publication is deferred
+     */
+    uint64_t t = ps->next;
+
+    /*
+     * Check if buffer is full
+     * The cached head is consulted first; the shared head is only
+     * reloaded when the cached copy says the ring looks full
+     */
+    if (spsc_ring_prod_room(ring, ps, t, 1) == 0)
+    {
+        return -1;  // Buffer is full, cannot push
+    }
+
+    /*
+     * Store the data at the current tail position
+     * Apply mask to wrap the index within buffer bounds
+     * This is a regular (non-atomic) store because only producer writes to this slot
+     */
+    spsc_ring_buf(ring)[t & ring->cfg.mask] = fd;
+
+    /*
+     * Advance the tail pointer atomically with release ordering
+     * Release ordering ensures that our buffer write above is visible
+     * to the consumer before this tail update becomes visible
+     * 
+     * This creates a happens-before relationship: buffer write → tail update
+     * Consumer will see tail update only after buffer write is complete
+     */
+    spsc_ring_publish_tail(ring, ps, t + 1);
+
+    /* Start fetching the slot ps->prefetch pushes ahead, if enabled */
+    spsc_ring_prefetch_prod(ring, ps, t, 1);
+
+    return 0;  // Success
+}
+
+/*
+ * Inline Pop (Consumer Function)
+ * ==============================
+ * 
+ * See spsc_ring_pop(). Returns 0 on success, -1 if the ring is empty.
+ * out_fd may be NULL to drop the element.
+ */
+static inline int spsc_ring_pop_local(spsc_ring_t *ring, spsc_ring_cons_local_t *cs, int *out_fd)
+{
+    if (ring->cfg.flags & SPSC_RING_SENTINEL)
+    {
+        return spsc_ring_pop_sentinel(ring, cs, out_fd);
+    }
+
+    /*
+     * Load current read position (where we'll read next)
+     * A plain load: cs->next is private to the consumer, and it runs
+     * ahead of the shared head while publication is deferred
+     */
+    uint64_t h = cs->next;
+
+    /*
+     * Check if buffer is empty
+     * The cached tail is consulted first; the shared tail is only
+     * reloaded when the cached copy says the ring looks empty
+     * 
+     * Empty condition: head == tail
+     * This means consumer has caught up to producer
+     */
+    if (spsc_ring_cons_ready(ring, cs, h, 1) == 0)
+    {
+        return -1;  // Buffer is empty, cannot pop
+    }
+
+    if (out_fd)
+    {
+        /*
+        * Read the data from current head position
+        * Apply mask to wrap the index within buffer bounds
+        * This is a regular (non-atomic) load because only consumer reads from this slot
+        * Store result in caller-provided output parameter
+        */
+        *out_fd = spsc_ring_buf(ring)[h & ring->cfg.mask];
+    }
+
+    /*
+     * Advance the head pointer atomically with release ordering
+     * Release ordering ensures that our buffer read above completes
+     * before this head update becomes visible to the producer
+     * 
+     * This creates a happens-before relationship: buffer read → head update
+     * Producer will see head update only after buffer read is complete
+     * This allows producer to safely reuse this buffer slot
+     */
+    spsc_ring_publish_head(ring, cs, h + 1);
+
+    /* Start fetching the slot cs->prefetch pops ahead, if enabled */
+    spsc_ring_prefetch_cons(ring, cs, h, 1);
+
+    return 0;  // Success
+}
+
+/*
+ * Ring-Level Inline Calls
+ * =======================
+ * 
+ * The calls above on the ring's own private state (prod.local /
+ * cons.local). A side whose endpoint handle is open must use the handle
+ * instead, see below.
+ */
+static inline int spsc_ring_is_full_inline(spsc_ring_t *ring)
+{
+    return spsc_ring_is_full_local(ring, &ring->prod.local);
+}
+
+static inline int spsc_ring_is_empty_inline(spsc_ring_t *ring)
+{
+    return spsc_ring_is_empty_local(ring, &ring->cons.local);
+}
+
+static inline int spsc_ring_push_inline(spsc_ring_t *ring, int fd)
+{
+    return spsc_ring_push_local(ring, &ring->prod.local, fd);
+}
+
+static inline int spsc_ring_pop_inline(spsc_ring_t *ring, int *out_fd)
+{
+    return spsc_ring_pop_local(ring, &ring->cons.local, out_fd);
+}
+
+/*
+ * Endpoint Handles
+ * ================
+ * 
+ * Layout of spsc_ring_producer_t / spsc_ring_consumer_t (see
+ * spsc_ring_open_producer()): the ring and the side's private state, on a
+ * cache line of their own that only the owning thread ever touches. The
+ * ring's prod / cons lines then only carry the shared index between open
+ * and close.
+ */
+struct spsc_ring_producer {
+    _Alignas(SPSC_RING_CACHE_LINE) spsc_ring_t *ring;
+    spsc_ring_prod_local_t local;  /* Taken over from ring->prod.local until close */
+};
+
+struct spsc_ring_consumer {
+    _Alignas(SPSC_RING_CACHE_LINE) spsc_ring_t *ring;
+    spsc_ring_cons_local_t local;  /* Taken over from ring->cons.local until close */
+};
+
+/* See spsc_ring_producer_push(); no NULL check */
+static inline int spsc_ring_producer_push_inline(spsc_ring_producer_t *prod, int fd)
+{
+    return spsc_ring_push_local(prod->ring, &prod->local, fd);
+}
+
+/* See spsc_ring_consumer_pop(); no NULL check */
+static inline int spsc_ring_consumer_pop_inline(spsc_ring_consumer_t *cons, int *out_fd)
+{
+    return spsc_ring_pop_local(cons->ring, &cons->local, out_fd);
+}
+
+#endif // SPSC_RING_INLINE_H
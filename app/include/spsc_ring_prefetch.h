@@ -0,0 +1,44 @@
+#ifndef SPSC_RING_PREFETCH_H
+#define SPSC_RING_PREFETCH_H
+
+/*
+ * Cache-line prefetch helpers shared by the inline int ring
+ * (spsc_ring_inline.h) and the typed rings (spsc_ring_typed.h). Not part of
+ * the ring API: it only exists so that neither header has to pull in the
+ * other.
+ */
+
+#include <stddef.h>      /* size_t */
+#include <stdint.h>      /* uintptr_t */
+
+#include "spsc_ring.h"   /* SPSC_RING_CACHE_LINE */
+
+/*
+ * Software prefetch hint used by the rings' prefetch distance (see
+ * spsc_ring_set_prefetch()); rw is 0 to read, 1 to write. A no-op on
+ * compilers without __builtin_prefetch.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define SPSC_RING_PREFETCH(addr, rw) __builtin_prefetch((addr), (rw), 3)
+#else
+#define SPSC_RING_PREFETCH(addr, rw) ((void)(addr))
+#endif
+
+/*
+ * Prefetches every cache line that starts inside [p, p + bytes): a run of
+ * small slots costs one hint per line rather than one per slot, and a
+ * slot larger than a line gets all of its lines.
+ */
+static inline void spsc_ring_prefetch_lines(const void *p, size_t bytes, int write)
+{
+    uintptr_t line = ((uintptr_t)p + SPSC_RING_CACHE_LINE - 1) &
+                     ~(uintptr_t)(SPSC_RING_CACHE_LINE - 1);
+    uintptr_t end  = (uintptr_t)p + bytes;
+    for (; line < end; line += SPSC_RING_CACHE_LINE)
+    {
+        if (write) SPSC_RING_PREFETCH((const void *)line, 1);
+        else       SPSC_RING_PREFETCH((const void *)line, 0);
+    }
+}
+
+#endif // SPSC_RING_PREFETCH_H
@@ -0,0 +1,312 @@
+#ifndef SPSC_RING_TYPED_H
+#define SPSC_RING_TYPED_H
+
+/*
+ * Typed SPSC Ring Buffers
+ * =======================
+ *
+ * SPSC_RING_DEFINE(name, T) generates a complete, header-only SPSC ring
+ * whose slots hold values of type T instead of int. It uses the same
+ * lock-free protocol as spsc_ring_t:
+ *
+ * - producer-owned (tail) and consumer-owned (head) state on separate
+ *   cache lines, read-mostly configuration on its own line
+ * - each side checks a private cached copy of the opposite index and only
+ *   reloads the shared atomic when that copy says full/empty
+ * - free-running 64-bit head/tail, so all capacity slots are usable
+ * - one release store publishes a whole bulk batch, copied with at most
+ *   two memcpy() segments around the wrap point
+ * - an optional prefetch distance (name_set_prefetch(), off by default),
+ *   as for spsc_ring_set_prefetch(); with large T every line of a slot is
+ *   hinted, so it tends to pay off at shorter distances than on int rings
+ * - bulk copies call memcpy() directly; only a ring whose name_set_copy()
+ *   installed spsc_ring_copy_fn hooks (e.g. the library's non-temporal
+ *   spsc_ring_copy_stream() for producers whose batches are far larger
+ *   than the cache) copies through the pointers. The header itself stays
+ *   self-contained: only rings that install the library's kernels need
+ *   to link it
+ *
+ * T must be trivially copyable (plain C data: scalars, pointers, structs
+ * without owning pointers). Like a heap spsc_ring_t, a typed ring is one
+ * allocation with the slots directly behind the structure, aligned for T
+ * (over-aligned record types included). Because sizeof(T) is a compile-time constant
+ * every slot copy below is specialised by the compiler for the element
+ * type, and all functions are static inline so they disappear into the
+ * caller's loop.
+ *
+ * Generated API (for SPSC_RING_DEFINE(msg_ring, struct msg)):
+ *
+ *   msg_ring_t *msg_ring_init(uint32_t capacity);
+ *   void        msg_ring_destroy(msg_ring_t **ring);
+ *   int         msg_ring_push(msg_ring_t *ring, struct msg value);
+ *   int         msg_ring_pop(msg_ring_t *ring, struct msg *out);
+ *   int         msg_ring_is_empty(msg_ring_t *ring);
+ *   int         msg_ring_is_full(msg_ring_t *ring);
+ *   uint32_t    msg_ring_push_bulk(msg_ring_t *ring, const struct msg *src, uint32_t n);
+ *   int         msg_ring_push_bulk_all(msg_ring_t *ring, const struct msg *src, uint32_t n);
+ *   uint32_t    msg_ring_pop_bulk(msg_ring_t *ring, struct msg *dst, uint32_t n);
+ *   int         msg_ring_pop_bulk_all(msg_ring_t *ring, struct msg *dst, uint32_t n);
+ *   int         msg_ring_set_prefetch(msg_ring_t *ring, uint32_t distance);
+ *   int         msg_ring_set_copy(msg_ring_t *ring, spsc_ring_copy_fn copy_in,
+ *                                 spsc_ring_copy_fn copy_out);
+ *
+ * Return values and thread-safety rules are identical to the corresponding
+ * spsc_ring_* functions (0 / -1, element counts for best-effort bulk calls,
+ * push-side calls from the producer only, pop-side calls from the consumer
+ * only). Use the macro once per element type, at file scope.
+ */
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spsc_ring.h"
+#include "spsc_ring_prefetch.h"
+
+#define SPSC_RING_DEFINE(name, T)                                                      \
+    typedef struct name {                                                              \
+        struct {                                                                       \
+            T        *buf;                                                             \
+            uint32_t  size, mask;                                                      \
+            uint32_t  prefetch;                                                        \
+            spsc_ring_copy_fn copy_in;   /* Bulk push copy, NULL = memcpy() */         \
+            spsc_ring_copy_fn copy_out;  /* Bulk pop copy, NULL = memcpy() */          \
+        } cfg;                                                                         \
+        _Alignas(SPSC_RING_CACHE_LINE) struct {                                        \
+            _Atomic uint64_t tail;                                                     \
+            uint64_t  cached_head;                                                     \
+        } prod;                                                                        \
+        _Alignas(SPSC_RING_CACHE_LINE) struct {                                        \
+            _Atomic uint64_t head;                                                     \
+            uint64_t  cached_tail;                                                     \
+        } cons;                                                                        \
+    } name##_t;                                                                        \
+                                                                                       \
+    static inline name##_t *name##_init(uint32_t capacity)                             \
+    {                                                                                  \
+        if ((capacity == 0) || ((capacity & (capacity - 1)) != 0))                     \
+        {                                                                              \
+            return NULL;                                                               \
+        }                                                                              \
+        /* One block: the structure, then the slots at _Alignof(T) */                  \
+        size_t align = (_Alignof(T) > _Alignof(name##_t)) ? _Alignof(T)                \
+                                                          : _Alignof(name##_t);        \
+        size_t off   = (sizeof(name##_t) + _Alignof(T) - 1) & ~(_Alignof(T) - 1);      \
+        if (capacity > (SIZE_MAX - off - align) / sizeof(T)) return NULL;              \
+        size_t bytes = off + (size_t)capacity * sizeof(T);                             \
+        bytes = (bytes + align - 1) & ~(align - 1);                                    \
+        name##_t *ring = aligned_alloc(align, bytes);                                  \
+        if (!ring) return NULL;                                                        \
+        memset(ring, 0, bytes);                                                        \
+        ring->cfg.size = capacity;                                                     \
+        ring->cfg.mask = capacity - 1;                                                 \
+        ring->cfg.buf  = (T *)(void *)((char *)ring + off);                            \
+        atomic_store(&ring->cons.head, 0);                                             \
+        atomic_store(&ring->prod.tail, 0);                                             \
+        return ring;                                                                   \
+    }                                                                                  \
+                                                                                       \
+    static inline void name##_destroy(name##_t **ring)                                 \
+    {                                                                                  \
+        if (ring && *ring)                                                             \
+        {                                                                              \
+            free(*ring);                                                               \
+            *ring = NULL;                                                              \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    static inline int name##_set_prefetch(name##_t *ring, uint32_t distance)           \
+    {                                                                                  \
+        if (!ring) return -1;                                                          \
+        ring->cfg.prefetch = (distance < ring->cfg.size) ? distance : ring->cfg.size;  \
+        return 0;                                                                      \
+    }                                                                                  \
+                                                                                       \
+    /* NULL restores the inlined memcpy() */                                           \
+    static inline int name##_set_copy(name##_t *ring, spsc_ring_copy_fn copy_in,       \
+                                      spsc_ring_copy_fn copy_out)                      \
+    {                                                                                  \
+        if (!ring) return -1;                                                          \
+        ring->cfg.copy_in  = copy_in;                                                  \
+        ring->cfg.copy_out = copy_out;                                                 \
+        return 0;                                                                      \
+    }                                                                                  \
+                                                                                       \
+    /* Hints slots [from, from + n) below end (see spsc_ring_prefetch_slots) */        \
+    static inline void name##_prefetch(name##_t *ring, uint64_t from, uint64_t end,    \
+                                       uint32_t n, int write)                          \
+    {                                                                                  \
+        if (from >= end) return;                                                       \
+        if (n > end - from) n = (uint32_t)(end - from);                                \
+        uint32_t idx   = (uint32_t)(from & ring->cfg.mask);                            \
+        uint32_t first = ring->cfg.size - idx;                                         \
+        if (first > n) first = n;                                                      \
+        spsc_ring_prefetch_lines(&ring->cfg.buf[idx], first * sizeof(T), write);       \
+        if (n > first)                                                                 \
+        {                                                                              \
+            spsc_ring_prefetch_lines(ring->cfg.buf, (n - first) * sizeof(T), write);   \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    static inline void name##_prefetch_prod(name##_t *ring, uint64_t t, uint32_t n)    \
+    {                                                                                  \
+        if (ring->cfg.prefetch != 0)                                                   \
+        {                                                                              \
+            name##_prefetch(ring, t + ring->cfg.prefetch,                              \
+                            ring->prod.cached_head + ring->cfg.size, n, 1);            \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    static inline void name##_prefetch_cons(name##_t *ring, uint64_t h, uint32_t n)    \
+    {                                                                                  \
+        if (ring->cfg.prefetch != 0)                                                   \
+        {                                                                              \
+            name##_prefetch(ring, h + ring->cfg.prefetch,                              \
+                            ring->cons.cached_tail, n, 0);                             \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    /* Free slots seen by the producer at tail t (see spsc_ring_prod_room) */          \
+    static inline uint32_t name##_prod_room(name##_t *ring, uint64_t t, uint32_t want) \
+    {                                                                                  \
+        uint32_t room = ring->cfg.size - (uint32_t)(t - ring->prod.cached_head);       \
+        if (room < want)                                                               \
+        {                                                                              \
+            ring->prod.cached_head =                                                   \
+                atomic_load_explicit(&ring->cons.head, memory_order_acquire);          \
+            room = ring->cfg.size - (uint32_t)(t - ring->prod.cached_head);            \
+        }                                                                              \
+        return room;                                                                   \
+    }                                                                                  \
+                                                                                       \
+    /* Readable elements seen by the consumer at head h */                             \
+    static inline uint32_t name##_cons_ready(name##_t *ring, uint64_t h, uint32_t want)\
+    {                                                                                  \
+        uint32_t ready = (uint32_t)(ring->cons.cached_tail - h);                       \
+        if (ready < want)                                                              \
+        {                                                                              \
+            ring->cons.cached_tail =                                                   \
+                atomic_load_explicit(&ring->prod.tail, memory_order_acquire);          \
+            ready = (uint32_t)(ring->cons.cached_tail - h);                            \
+        }                                                                              \
+        return ready;                                                                  \
+    }                                                                                  \
+                                                                                       \
+    static inline int name##_is_full(name##_t *ring)                                   \
+    {                                                                                  \
+        uint64_t t = atomic_load_explicit(&ring->prod.tail, memory_order_relaxed);     \
+        return name##_prod_room(ring, t, 1) == 0;                                      \
+    }                                                                                  \
+                                                                                       \
+    static inline int name##_is_empty(name##_t *ring)                                  \
+    {                                                                                  \
+        uint64_t h = atomic_load_explicit(&ring->cons.head, memory_order_relaxed);     \
+        return name##_cons_ready(ring, h, 1) == 0;                                     \
+    }                                                                                  \
+                                                                                       \
+    static inline int name##_push(name##_t *ring, T value)                             \
+    {                                                                                  \
+        uint64_t t = atomic_load_explicit(&ring->prod.tail, memory_order_relaxed);     \
+        if (name##_prod_room(ring, t, 1) == 0)                                         \
+        {                                                                              \
+            return -1;                                                                 \
+        }                                                                              \
+        ring->cfg.buf[t & ring->cfg.mask] = value;                                     \
+        atomic_store_explicit(&ring->prod.tail, t + 1, memory_order_release);          \
+        name##_prefetch_prod(ring, t, 1);                                              \
+        return 0;                                                                      \
+    }                                                                                  \
+                                                                                       \
+    static inline int name##_pop(name##_t *ring, T *out)                               \
+    {                                                                                  \
+        uint64_t h = atomic_load_explicit(&ring->cons.head, memory_order_relaxed);     \
+        if (name##_cons_ready(ring, h, 1) == 0)                                        \
+        {                                                                              \
+            return -1;                                                                 \
+        }                                                                              \
+        if (out) *out = ring->cfg.buf[h & ring->cfg.mask];                             \
+        atomic_store_explicit(&ring->cons.head, h + 1, memory_order_release);          \
+        name##_prefetch_cons(ring, h, 1);                                              \
+        return 0;                                                                      \
+    }                                                                                  \
+                                                                                       \
+    static inline uint32_t name##_push_n(name##_t *ring, const T *src, uint32_t n,     \
+                                         int all)                                      \
+    {                                                                                  \
+        uint64_t t    = atomic_load_explicit(&ring->prod.tail, memory_order_relaxed);  \
+        uint32_t room = name##_prod_room(ring, t, n);                                  \
+        if (room < n)                                                                  \
+        {                                                                              \
+            if (all) return 0;                                                         \
+            n = room;                                                                  \
+        }                                                                              \
+        if (n == 0) return 0;                                                          \
+        uint32_t idx   = (uint32_t)(t & ring->cfg.mask);                               \
+        uint32_t first = ring->cfg.size - idx;                                         \
+        if (first > n) first = n;                                                      \
+        if (ring->cfg.copy_in)                                                         \
+        {                                                                              \
+            ring->cfg.copy_in(&ring->cfg.buf[idx], src, first * sizeof(T));            \
+            ring->cfg.copy_in(ring->cfg.buf, src + first, (n - first) * sizeof(T));    \
+        }                                                                              \
+        else                                                                           \
+        {                                                                              \
+            memcpy(&ring->cfg.buf[idx], src, first * sizeof(T));                       \
+            memcpy(ring->cfg.buf, src + first, (n - first) * sizeof(T));               \
+        }                                                                              \
+        atomic_store_explicit(&ring->prod.tail, t + n, memory_order_release);          \
+        name##_prefetch_prod(ring, t, n);                                              \
+        return n;                                                                      \
+    }                                                                                  \
+                                                                                       \
+    static inline uint32_t name##_pop_n(name##_t *ring, T *dst, uint32_t n, int all)   \
+    {                                                                                  \
+        uint64_t h     = atomic_load_explicit(&ring->cons.head, memory_order_relaxed); \
+        uint32_t ready = name##_cons_ready(ring, h, n);                                \
+        if (ready < n)                                                                 \
+        {                                                                              \
+            if (all) return 0;                                                         \
+            n = ready;                                                                 \
+        }                                                                              \
+        if (n == 0) return 0;                                                          \
+        uint32_t idx   = (uint32_t)(h & ring->cfg.mask);                               \
+        uint32_t first = ring->cfg.size - idx;                                         \
+        if (first > n) first = n;                                                      \
+        if (ring->cfg.copy_out)                                                        \
+        {                                                                              \
+            ring->cfg.copy_out(dst, &ring->cfg.buf[idx], first * sizeof(T));           \
+            ring->cfg.copy_out(dst + first, ring->cfg.buf, (n - first) * sizeof(T));   \
+        }                                                                              \
+        else                                                                           \
+        {                                                                              \
+            memcpy(dst, &ring->cfg.buf[idx], first * sizeof(T));                       \
+            memcpy(dst + first, ring->cfg.buf, (n - first) * sizeof(T));               \
+        }                                                                              \
+        atomic_store_explicit(&ring->cons.head, h + n, memory_order_release);          \
+        name##_prefetch_cons(ring, h, n);                                              \
+        return n;                                                                      \
+    }                                                                                  \
+                                                                                       \
+    static inline uint32_t name##_push_bulk(name##_t *ring, const T *src, uint32_t n)  \
+    {                                                                                  \
+        return name##_push_n(ring, src, n, 0);                                         \
+    }                                                                                  \
+                                                                                       \
+    static inline int name##_push_bulk_all(name##_t *ring, const T *src, uint32_t n)   \
+    {                                                                                  \
+        return (name##_push_n(ring, src, n, 1) == n) ? 0 : -1;                         \
+    }                                                                                  \
+                                                                                       \
+    static inline uint32_t name##_pop_bulk(name##_t *ring, T *dst, uint32_t n)         \
+    {                                                                                  \
+        return name##_pop_n(ring, dst, n, 0);                                          \
+    }                                                                                  \
+                                                                                       \
+    static inline int name##_pop_bulk_all(name##_t *ring, T *dst, uint32_t n)          \
+    {                                                                                  \
+        return (name##_pop_n(ring, dst, n, 1) == n) ? 0 : -1;                          \
+    }
+
+#endif // SPSC_RING_TYPED_H
@@ -0,0 +1,465 @@
+/*
+ * SPSC Variable-Length Message Ring
+ * =================================
+ *
+ * Byte-oriented variant of the SPSC ring: instead of fixed int slots the
+ * producer writes length-prefixed records of arbitrary size and the
+ * consumer reads them in place through pointer + length views.
+ *
+ * It is not a second implementation of the protocol: a message ring is an
+ * ordinary spsc_ring_t (spsc_ring_init_ex() with capacity_bytes / 4 int
+ * slots) whose slots hold the records, driven through the same helpers as
+ * the int ring (spsc_ring_inline.h):
+ * - spsc_ring_prod_room() / spsc_ring_cons_ready() for the cached-index
+ *   checks, on the ring's own prod.local / cons.local state
+ * - spsc_ring_publish_tail() / spsc_ring_publish_head() for every index
+ *   store, so deferred publication (spsc_msg_ring_set_lazy()), the
+ *   SPSC_RING_BLOCKING wake-ups and the SPSC_RING_EVENTFD edge behave
+ *   exactly as on an int ring
+ * - the ring's slot layout (slots behind the structure, or double-mapped
+ *   with SPSC_RING_MAGIC) and spsc_ring_destroy()
+ *
+ * The indices therefore count 4-byte slots; a record always covers a whole
+ * number of 8-byte units, i.e. an even number of slots.
+ *
+ * Record Format:
+ *
+ *   +----------------+----------------+---------------------------+
+ *   | len (uint32_t) | flags (uint32) | payload, padded to 8 bytes |
+ *   +----------------+----------------+---------------------------+
+ *
+ * Every record starts on an 8-byte boundary, so payloads are 8-byte aligned
+ * and can be cast to structs holding 64-bit fields. A record never wraps:
+ * when it does not fit before the end of buf, the producer fills the tail
+ * end with a skip record (flags = SPSC_MSG_PAD) and writes the record at
+ * offset 0. The skip record and the record are published by the same tail
+ * store, and the consumer steps over skip records transparently.
+ *
+ * With SPSC_RING_MAGIC (spsc_msg_ring_init_ex()) the buffer is mapped
+ * twice back to back (see spsc_ring_magic.c): a record running past the
+ * end of buf simply continues in the second mapping, so no skip records
+ * are ever written and a single message may use the whole buffer.
+ *
+ * Thread Safety:
+ * - Safe for ONE producer thread and ONE consumer thread
+ */
+
+#include "spsc_msg_ring.h"
+#include "spsc_ring_inline.h"
+#include "spsc_ring_internal.h"
+
+#include <errno.h>       /* errno, EINVAL */
+#include <stdatomic.h>   /* C11 atomic operations and memory ordering */
+#include <stdlib.h>      /* aligned_alloc, free */
+#include <stdint.h>      /* uint32_t, uint64_t and other fixed-width integer types */
+#include <string.h>      /* memcpy, memset */
+
+#define SPSC_MSG_ALIGN 8u          /* Record alignment in bytes */
+#define SPSC_MSG_PAD   1u          /* flags value of a skip record */
+#define SPSC_MSG_SLOT  ((uint32_t)sizeof(int))   /* Bytes per ring slot */
+
+/* Flags a message ring accepts: everything but the slot-marker mode */
+#define SPSC_MSG_FLAGS (SPSC_RING_FLAGS_ALL & ~SPSC_RING_SENTINEL)
+
+typedef struct spsc_msg_hdr {
+    uint32_t len;                  /* Payload bytes (skip records: bytes skipped) */
+    uint32_t flags;                /* 0 for a message, SPSC_MSG_PAD for padding */
+} spsc_msg_hdr_t;
+
+/*
+ * Message Ring Structure
+ * ======================
+ *
+ * - ring: the spsc_ring_t carrying the records (indices, cached indices,
+ *         lazy / blocking / eventfd state, streaming threshold)
+ * - prod: the producer's open reservation, on its own line
+ */
+struct spsc_msg_ring{
+    spsc_ring_t *ring;
+
+    _Alignas(SPSC_RING_CACHE_LINE) struct {
+        uint32_t   pad;            /* Skip slots in front of the open reservation */
+        uint32_t   reserved;       /* Payload bytes of the open reservation */
+        int        reserving;      /* Non-zero while a reservation is open */
+    } prod;
+};
+
+/* Ring slots covered by a record of len payload bytes */
+static inline uint32_t spsc_msg_slots(uint32_t len)
+{
+    uint32_t bytes = (uint32_t)sizeof(spsc_msg_hdr_t) + ((len + SPSC_MSG_ALIGN - 1) & ~(SPSC_MSG_ALIGN - 1));
+    return bytes / SPSC_MSG_SLOT;
+}
+
+static inline spsc_msg_hdr_t *spsc_msg_hdr_at(spsc_ring_t *ring, uint64_t idx)
+{
+    return (spsc_msg_hdr_t *)(void *)&spsc_ring_buf(ring)[idx & ring->cfg.mask];
+}
+
+/*
+ * Message Ring Initialization Function
+ * ====================================
+ *
+ * Parameters:
+ * - capacity_bytes: Size of the record buffer in bytes. MUST be a power of
+ *                   2 and at least 16 (one header plus one 8-byte payload)
+ * - flags:          As for spsc_ring_init_ex(), except SPSC_RING_SENTINEL:
+ *                   SPSC_RING_MAGIC double-maps the buffer (capacity_bytes
+ *                   must then be a multiple of the page size),
+ *                   SPSC_RING_BLOCKING enables spsc_msg_ring_push_wait() /
+ *                   spsc_msg_ring_peek_wait(), SPSC_RING_EVENTFD
+ *                   spsc_msg_ring_get_eventfd(), and the page flags apply
+ *                   to the buffer (spsc_msg_ring_init() passes 0)
+ *
+ * Returns:
+ * - Pointer to the new ring, or NULL on invalid arguments / out of memory
+ *
+ * The largest message that is guaranteed to fit, whatever the current
+ * position of tail, is spsc_msg_ring_max_msg(): capacity_bytes / 2 - 8,
+ * or capacity_bytes - 8 on a magic ring, which never pads.
+ *
+ * Thread Safety:
+ * - Call before the producer/consumer threads start
+ */
+spsc_msg_ring_t *spsc_msg_ring_init(uint32_t capacity_bytes)
+{
+    return spsc_msg_ring_init_ex(capacity_bytes, 0);
+}
+
+spsc_msg_ring_t *spsc_msg_ring_init_ex(uint32_t capacity_bytes, uint32_t flags)
+{
+    if ((capacity_bytes < 2 * sizeof(spsc_msg_hdr_t)) ||
+        ((capacity_bytes & (capacity_bytes - 1)) != 0) ||
+        (flags & ~SPSC_MSG_FLAGS) != 0)
+    {
+        return NULL;
+    }
+
+    spsc_msg_ring_t *ring = aligned_alloc(_Alignof(spsc_msg_ring_t), sizeof(*ring));
+    if(!ring) return NULL;
+    memset(ring, 0, sizeof(*ring));
+
+    ring->ring = spsc_ring_init_ex(capacity_bytes / SPSC_MSG_SLOT, flags);
+    if(!ring->ring)
+    {
+        free(ring);
+        return NULL;
+    }
+    return ring;
+}
+
+uint32_t spsc_msg_ring_max_msg(spsc_msg_ring_t *ring)
+{
+    if (ring == NULL) return 0;
+    uint32_t bytes = ring->ring->cfg.size * SPSC_MSG_SLOT;
+    if (ring->ring->cfg.flags & SPSC_RING_MAGIC)
+    {
+        return bytes - (uint32_t)sizeof(spsc_msg_hdr_t);
+    }
+    return bytes / 2 - (uint32_t)sizeof(spsc_msg_hdr_t);
+}
+
+/*
+ * Message Reserve / Commit (Producer Functions)
+ * =============================================
+ *
+ * spsc_msg_ring_reserve() returns an 8-byte aligned, contiguous area of len
+ * bytes inside the ring for the producer to fill in place. If the record
+ * would cross the end of buf, a skip record is written over the remaining
+ * bytes and the area starts at offset 0 instead (magic rings just let it
+ * run on into the second mapping). Nothing is visible to the consumer yet.
+ *
+ * spsc_msg_ring_commit() publishes the reserved record with its final
+ * length (which may be shorter than the reserved one), together with any
+ * skip record in front of it, through spsc_ring_publish_tail().
+ *
+ * Returns:
+ * - reserve: pointer to the payload area, NULL if the ring has no room
+ *   right now, len exceeds spsc_msg_ring_max_msg() or ring is NULL
+ * - commit:  0 on success, -1 if no reservation is open or len exceeds it
+ *
+ * Thread Safety:
+ * - Producer thread only; a new reserve replaces an uncommitted one
+ */
+static void *spsc_msg_reserve(spsc_msg_ring_t *ring, uint32_t len, int64_t timeout_ns)
+{
+    spsc_ring_t            *r  = ring->ring;
+    spsc_ring_prod_local_t *ps = &r->prod.local;
+
+    uint64_t t      = ps->next;
+    uint32_t need   = spsc_msg_slots(len);
+    uint32_t to_end = r->cfg.size - (uint32_t)(t & r->cfg.mask);
+    uint32_t pad    = (to_end < need && !(r->cfg.flags & SPSC_RING_MAGIC)) ? to_end : 0;
+
+    ring->prod.reserving = 0;
+    if (spsc_ring_prod_room(r, ps, t, pad + need) < pad + need &&
+        (timeout_ns == 0 || spsc_ring_wait_room(r, ps, pad + need, timeout_ns) != 0))
+    {
+        return NULL;
+    }
+
+    if (pad)
+    {
+        /*
+         * Not published yet: the skip record becomes visible together with
+         * the message when commit advances tail past both of them
+         */
+        spsc_msg_hdr_t *skip = spsc_msg_hdr_at(r, t);
+        skip->len   = pad * SPSC_MSG_SLOT - (uint32_t)sizeof(spsc_msg_hdr_t);
+        skip->flags = SPSC_MSG_PAD;
+    }
+
+    ring->prod.pad       = pad;
+    ring->prod.reserved  = len;
+    ring->prod.reserving = 1;
+    return spsc_msg_hdr_at(r, t + pad) + 1;
+}
+
+void *spsc_msg_ring_reserve(spsc_msg_ring_t *ring, uint32_t len)
+{
+    if (ring == NULL || len > spsc_msg_ring_max_msg(ring))
+    {
+        return NULL;
+    }
+    return spsc_msg_reserve(ring, len, 0);
+}
+
+int spsc_msg_ring_commit(spsc_msg_ring_t *ring, uint32_t len)
+{
+    if (ring == NULL || !ring->prod.reserving || len > ring->prod.reserved)
+    {
+        return -1;
+    }
+
+    spsc_ring_t            *r   = ring->ring;
+    spsc_ring_prod_local_t *ps  = &r->prod.local;
+    uint64_t                pos = ps->next + ring->prod.pad;
+
+    spsc_msg_hdr_t *hdr = spsc_msg_hdr_at(r, pos);
+    hdr->len   = len;
+    hdr->flags = 0;
+
+    ring->prod.reserving = 0;
+
+    /* Publish skip record (if any), header and payload in one step */
+    spsc_ring_publish_tail(r, ps, pos + spsc_msg_slots(len));
+    return 0;
+}
+
+/*
+ * Message Push (Producer Function)
+ * ================================
+ *
+ * Convenience wrapper: reserve len bytes, copy data in, commit.
+ * spsc_msg_ring_push_wait() waits for room instead of failing (timeout_ns
+ * as for spsc_ring_push_wait(); SPSC_RING_BLOCKING rings only, else -1
+ * with errno = EINVAL; ETIMEDOUT if no room freed up in time).
+ *
+ * The payload is copied with memcpy(). spsc_msg_ring_set_stream() makes
+ * messages of at least min_bytes bytes use spsc_ring_copy_stream()
+ * instead (the non-temporal kernel picked for this CPU, see
+ * spsc_ring_copy.c), which does not pull the ring's lines into the
+ * producer's cache (0, the default, turns that off); it is the ring's
+ * spsc_ring_set_stream() threshold. It returns 0, or -1 if ring is NULL.
+ *
+ * Returns:
+ * - 0: Success
+ * - -1: No room right now, message too large or invalid arguments
+ */
+static int spsc_msg_push(spsc_msg_ring_t *ring, const void *data, uint32_t len, int64_t timeout_ns)
+{
+    void *dst = spsc_msg_reserve(ring, len, timeout_ns);
+    if (dst == NULL)
+    {
+        return -1;
+    }
+    if (len)
+    {
+        uint32_t stream_min = ring->ring->prod.local.stream_min;
+        if (stream_min != 0 && len >= stream_min)
+        {
+            spsc_ring_copy_stream(dst, data, len);
+        }
+        else
+        {
+            memcpy(dst, data, len);
+        }
+    }
+    return spsc_msg_ring_commit(ring, len);
+}
+
+int spsc_msg_ring_push(spsc_msg_ring_t *ring, const void *data, uint32_t len)
+{
+    if (ring == NULL || (data == NULL && len != 0) || len > spsc_msg_ring_max_msg(ring))
+    {
+        return -1;
+    }
+    return spsc_msg_push(ring, data, len, 0);
+}
+
+int spsc_msg_ring_push_wait(spsc_msg_ring_t *ring, const void *data, uint32_t len,
+                            int64_t timeout_ns)
+{
+    if (ring == NULL || (data == NULL && len != 0) || len > spsc_msg_ring_max_msg(ring) ||
+        !(ring->ring->cfg.flags & SPSC_RING_BLOCKING))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return spsc_msg_push(ring, data, len, timeout_ns);
+}
+
+int spsc_msg_ring_set_stream(spsc_msg_ring_t *ring, uint32_t min_bytes)
+{
+    if (ring == NULL)
+    {
+        return -1;
+    }
+    return spsc_ring_set_stream(ring->ring, min_bytes);
+}
+
+/*
+ * Message Peek / Release (Consumer Functions)
+ * ===========================================
+ *
+ * spsc_msg_ring_peek() returns a read-only view of the oldest message and
+ * its length without copying it. Skip records in front of it are consumed
+ * on the way (their bytes are handed back to the producer immediately).
+ * spsc_msg_ring_peek_wait() waits for a message instead of returning NULL
+ * (timeout_ns as for spsc_ring_pop_wait(); SPSC_RING_BLOCKING rings only,
+ * else NULL with errno = EINVAL; ETIMEDOUT if nothing arrived in time).
+ *
+ * spsc_msg_ring_release() consumes the message returned by the last peek
+ * and hands its bytes back to the producer through
+ * spsc_ring_publish_head().
+ *
+ * Returns:
+ * - peek:    pointer to the payload (8-byte aligned), NULL if the ring is
+ *            empty or on invalid arguments
+ * - release: 0 on success, -1 if the ring is empty or ring is NULL
+ *
+ * Thread Safety:
+ * - Consumer thread only; the view stays valid until it is released
+ */
+const void *spsc_msg_ring_peek(spsc_msg_ring_t *ring, uint32_t *out_len)
+{
+    if (ring == NULL || out_len == NULL)
+    {
+        return NULL;
+    }
+
+    spsc_ring_t            *r  = ring->ring;
+    spsc_ring_cons_local_t *cs = &r->cons.local;
+    uint64_t                h  = cs->next;
+    for(;;)
+    {
+        if (spsc_ring_cons_ready(r, cs, h, 1) == 0)
+        {
+            return NULL;
+        }
+
+        const spsc_msg_hdr_t *hdr = spsc_msg_hdr_at(r, h);
+        if (hdr->flags != SPSC_MSG_PAD)
+        {
+            *out_len = hdr->len;
+            return hdr + 1;
+        }
+
+        h += ((uint32_t)sizeof(spsc_msg_hdr_t) + hdr->len) / SPSC_MSG_SLOT;
+        spsc_ring_publish_head(r, cs, h);
+    }
+}
+
+const void *spsc_msg_ring_peek_wait(spsc_msg_ring_t *ring, uint32_t *out_len, int64_t timeout_ns)
+{
+    if (ring == NULL || out_len == NULL || !(ring->ring->cfg.flags & SPSC_RING_BLOCKING))
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    for(;;)
+    {
+        const void *view = spsc_msg_ring_peek(ring, out_len);
+        if (view != NULL ||
+            spsc_ring_wait_ready(ring->ring, &ring->ring->cons.local, timeout_ns) != 0)
+        {
+            return view;
+        }
+    }
+}
+
+int spsc_msg_ring_release(spsc_msg_ring_t *ring)
+{
+    uint32_t len = 0;
+    if (spsc_msg_ring_peek(ring, &len) == NULL)
+    {
+        return -1;
+    }
+
+    spsc_ring_cons_local_t *cs = &ring->ring->cons.local;
+    spsc_ring_publish_head(ring->ring, cs, cs->next + spsc_msg_slots(len));
+    return 0;
+}
+
+int spsc_msg_ring_is_empty(spsc_msg_ring_t *ring)
+{
+    uint32_t len = 0;
+    return spsc_msg_ring_peek(ring, &len) == NULL;
+}
+
+/*
+ * Ring-Level Settings
+ * ===================
+ *
+ * Forward to the underlying spsc_ring_t, with the same semantics:
+ * - spsc_msg_ring_set_lazy(): spsc_ring_set_lazy(); tail_batch counts ring
+ *   slots (4 bytes of record each) rather than messages
+ * - spsc_msg_ring_flush():    spsc_ring_flush() (producer only)
+ * - spsc_msg_ring_get_eventfd() / spsc_msg_ring_eventfd_drain(): the
+ *   SPSC_RING_EVENTFD descriptor; the peek that finds the ring empty
+ *   re-arms it
+ *
+ * Each returns -1 if ring is NULL.
+ */
+int spsc_msg_ring_set_lazy(spsc_msg_ring_t *ring, uint32_t tail_batch, uint64_t flush_after_ns)
+{
+    if (ring == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return spsc_ring_set_lazy(ring->ring, tail_batch, flush_after_ns);
+}
+
+int spsc_msg_ring_flush(spsc_msg_ring_t *ring)
+{
+    return (ring == NULL) ? -1 : spsc_ring_flush(ring->ring);
+}
+
+int spsc_msg_ring_get_eventfd(spsc_msg_ring_t *ring)
+{
+    return (ring == NULL) ? -1 : spsc_ring_get_eventfd(ring->ring);
+}
+
+int spsc_msg_ring_eventfd_drain(spsc_msg_ring_t *ring)
+{
+    return (ring == NULL) ? -1 : spsc_ring_eventfd_drain(ring->ring);
+}
+
+/*
+ * Message Ring Cleanup Function
+ * =============================
+ *
+ * Destroys the underlying ring, frees the message ring and sets *ring to
+ * NULL. Call only after both threads have stopped using the ring.
+ */
+void spsc_msg_ring_destroy(spsc_msg_ring_t **ring)
+{
+    if (ring && *ring)
+    {
+        spsc_ring_destroy(&(*ring)->ring);
+        free(*ring);
+        *ring = NULL;
+    }
+}
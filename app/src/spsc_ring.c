@@ -10,7 +10,8 @@
  * - Lock-free design using C11 atomic operations
  * - Memory ordering guarantees for correct synchronization
  * - Power-of-two capacity for efficient modulo operations using bitwise AND
- * - Distinguishes between full and empty states without sacrificing a slot
+ * - Free-running 64-bit head/tail: every slot is usable, full and empty are
+ *   told apart by tail - head instead of by sacrificing a slot
  * 
  * Thread Safety:
  * - Safe for ONE producer thread and ONE consumer thread
@@ -19,39 +20,20 @@
  */
 
 #include "spsc_ring.h"
+#include "spsc_ring_inline.h"  /* struct spsc_ring layout and inline fast paths */
+#include "spsc_ring_internal.h"
 
+#include <errno.h>       /* errno, EINVAL, EBUSY, ENOMEM */
 #include <stdatomic.h>   /* C11 atomic operations and memory ordering */
-#include <stdlib.h>      /* malloc, calloc, free */
-#include <stdint.h>      /* uint32_t and other fixed-width integer types */
+#include <stdlib.h>      /* aligned_alloc, free */
+#include <stdint.h>      /* uint32_t, uint64_t and other fixed-width integer types */
+#include <string.h>      /* memset */
+#include <time.h>        /* clock_gettime */
 
-/*
- * SPSC Ring Buffer Structure
- * ==========================
- * 
- * The ring buffer uses a circular array with head and tail pointers.
- * The key insight is that we can distinguish between full and empty
- * states by checking if (tail + 1) == head (full) vs tail == head (empty).
- * 
- * Memory Layout:
- * - buf: Dynamically allocated array storing the actual data
- * - size: Total capacity (must be power of 2 for efficient masking)
- * - mask: Bitmask for wrapping indices (size - 1)
- * - head: Consumer's read position (atomic for thread safety)
- * - tail: Producer's write position (atomic for thread safety)
- * 
- * Invariants:
- * - size is always a power of 2
- * - mask = size - 1
- * - head and tail can wrap around using modulo arithmetic
- * - Buffer is empty when: head == tail
- * - Buffer is full when: (tail + 1) & mask == head & mask
- */
-struct spsc_ring{
-    int       *buf;            /* Circular buffer array of integers */
-    uint32_t   size, mask;     /* Size must be power of two; mask = size−1 for fast modulo */
-    _Atomic uint32_t head;     /* Consumer's read index (atomically updated) */
-    _Atomic uint32_t tail;     /* Producer's write index (atomically updated) */
-};
+#ifdef __linux__
+#include <sys/eventfd.h> /* eventfd, EFD_NONBLOCK, EFD_CLOEXEC */
+#include <unistd.h>      /* close */
+#endif
 
 /*
  * Ring Buffer Initialization Function
@@ -72,12 +54,45 @@ struct spsc_ring{
  * - Returns address of global 'g_ring' instance
  * 
  * Memory Initialization:
- * - Allocates buffer memory using calloc() (zeros the memory)
+ * - Allocates the ring structure and its slots as ONE block with
+ *   aligned_alloc(), so that cfg, prod and cons really start on separate
+ *   cache lines and the slots follow the structure directly: reaching a
+ *   slot is an add on cfg.buf_off, never a load of a separate pointer
+ * - The slots are not zeroed: every slot is written before it is read,
+ *   and clearing a large ring is pure startup cost
  * - Sets head and tail to 0 using atomic_store for thread safety
  * - Calculates mask for efficient index wrapping
  * 
  * Example Usage:
  *   spsc_ring_t *my_ring = spsc_ring_init(16);  // 16-element buffer
+ *   spsc_ring_t *blocking = spsc_ring_init_ex(16, SPSC_RING_BLOCKING);
+ * 
+ * Flags (spsc_ring_init_ex() only, spsc_ring_init() passes 0):
+ * - SPSC_RING_BLOCKING: enables spsc_ring_pop_wait()/spsc_ring_push_wait().
+ *   Every publish then also checks whether the peer is parked (see
+ *   spsc_ring_publish_tail()); rings without the flag skip that check.
+ * - SPSC_RING_EVENTFD: the ring owns a non-blocking eventfd that becomes
+ *   readable when data arrives in a ring the consumer found empty (see
+ *   spsc_ring_get_eventfd()). Linux only; fails elsewhere.
+ * - SPSC_RING_MAGIC: the slots are mapped twice back to back (see
+ *   spsc_ring_magic.c), so bulk copies and reserve/peek spans never split
+ *   at the end of the buffer. capacity * sizeof(int) must be a multiple of
+ *   the page size (capacity >= 1024 with 4 KiB pages). Linux only.
+ * - SPSC_RING_HUGEPAGE / SPSC_RING_POPULATE / SPSC_RING_MLOCK: take the
+ *   block from an anonymous mapping backed by huge pages (falling back to
+ *   transparent huge pages), prefaulted, and/or locked in memory, so a
+ *   fresh ring takes no page faults or 4 KiB TLB misses on its first trip
+ *   around (see spsc_ring_pages.c; on magic rings they apply to the slot
+ *   mapping). Huge pages are best-effort, a failed mlock() fails the call.
+ *   Linux only.
+ * - SPSC_RING_SENTINEL: free slots hold SPSC_RING_EMPTY_SLOT and each side
+ *   only looks at the slots, never at the other side's index (see
+ *   spsc_ring_sentinel_room() in spsc_ring_inline.h). The slots are filled
+ *   with SPSC_RING_EMPTY_SLOT here, and -1 can no longer be pushed. Not
+ *   combinable with SPSC_RING_BLOCKING, SPSC_RING_EVENTFD or
+ *   SPSC_RING_MAGIC, and such a ring has no reserve/commit, peek/release
+ *   or deferred publication.
+ * Unknown flags make the call fail.
  * 
  * Thread Safety:
  * - This function should be called BEFORE any producer/consumer threads start
@@ -85,15 +100,84 @@ struct spsc_ring{
  */
 spsc_ring_t *spsc_ring_init(uint32_t capacity)
 {
+    return spsc_ring_init_ex(capacity, 0);
+}
+
+static spsc_ring_t *spsc_ring_init_heap(uint32_t capacity, uint32_t flags,
+                                        const spsc_numa_policy_t *numa);
+
+/* Releases the block of a heap ring, however spsc_ring_init_ex() got it */
+static void spsc_ring_free_block(spsc_ring_t *ring)
+{
+    if (ring->cfg.map_bytes != 0)
+    {
+        spsc_pages_unmap(ring, ring->cfg.map_bytes);
+    }
+    else
+    {
+        free(ring);
+    }
+}
+
+spsc_ring_t *spsc_ring_init_ex(uint32_t capacity, uint32_t flags)
+{
+    return spsc_ring_init_heap(capacity, flags, NULL);
+}
 
+/*
+ * Heap ring construction shared by spsc_ring_init_ex() and
+ * spsc_ring_init_numa_ex(); numa, when not NULL, is the memory policy the
+ * block is bound to (which always takes the mapped path).
+ */
+static spsc_ring_t *spsc_ring_init_heap(uint32_t capacity, uint32_t flags,
+                                        const spsc_numa_policy_t *numa)
+{
     if ((capacity == 0) || ((capacity & (capacity - 1)) != 0))  // Check if capacity is a power of 2
     {
         return NULL;  // Invalid capacity, return NULL
     }
+    else if ((flags & ~SPSC_RING_FLAGS_ALL) != 0)
+    {
+        return NULL;  // Unknown flag
+    }
+    else if ((flags & SPSC_RING_MAGIC) && !spsc_magic_size_ok((uint64_t)capacity * sizeof(int)))
+    {
+        return NULL;  // The double mapping needs whole pages of slots
+    }
+    else if ((flags & SPSC_RING_SENTINEL) &&
+             (flags & (SPSC_RING_BLOCKING | SPSC_RING_EVENTFD | SPSC_RING_MAGIC)))
+    {
+        return NULL;  // Waiters and spans rely on the shared indices
+    }
     else
     {
-        spsc_ring_t *ring = calloc(1, sizeof(*ring));
+        /*
+         * The structure carries _Alignas(SPSC_RING_CACHE_LINE) members, so its
+         * size is already a multiple of the cache line and the slots placed
+         * right behind it start on a fresh line. calloc()/malloc() only
+         * guarantee max_align_t alignment, which would let prod and cons
+         * straddle lines. aligned_alloc() wants the total rounded up to the
+         * alignment. Magic rings map their slots separately. With any of the
+         * page flags the block is mapped instead (always page-aligned).
+         */
+        size_t bytes = sizeof(spsc_ring_t);
+        if (!(flags & SPSC_RING_MAGIC))
+        {
+            uint64_t total = (uint64_t)sizeof(spsc_ring_t) + (uint64_t)capacity * sizeof(int);
+            total = (total + _Alignof(spsc_ring_t) - 1) & ~(uint64_t)(_Alignof(spsc_ring_t) - 1);
+            if (total > SIZE_MAX)
+            {
+                return NULL;  // Does not fit the address space (32-bit targets)
+            }
+            bytes = (size_t)total;
+        }
+        uint64_t     mapped = 0;
+        spsc_ring_t *ring   = ((numa != NULL || (flags & SPSC_RING_PAGE_FLAGS)) && !(flags & SPSC_RING_MAGIC))
+                            ? spsc_pages_map(bytes, flags, numa, &mapped)
+                            : aligned_alloc(_Alignof(spsc_ring_t), bytes);
         if(!ring) return NULL;
+        memset(ring, 0, sizeof(*ring));
+        ring->cfg.map_bytes = mapped;
         /* 
          * Store the capacity and calculate the bitmask
          * The mask allows us to efficiently wrap indices:
@@ -101,36 +185,177 @@ spsc_ring_t *spsc_ring_init(uint32_t capacity)
          * We use: index & mask (fast bitwise AND)
          * This only works when size is a power of 2!
          */
-        ring->size = capacity;
-        ring->mask = capacity - 1;
+        ring->cfg.size = capacity;
+        ring->cfg.mask = capacity - 1;
+        ring->cfg.flags = flags;
+        ring->cfg.spin  = SPSC_RING_DEFAULT_SPIN;
+        ring->cfg.efd   = -1;
+        ring->cfg.map_fd = -1;
+        ring->cfg.probe  = 1;
+
+        if (flags & SPSC_RING_EVENTFD)
+        {
+#ifdef __linux__
+            ring->cfg.efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+            if (ring->cfg.efd < 0)
+            {
+                spsc_ring_free_block(ring);
+                return NULL;
+            }
+            /* The ring starts empty, so the consumer starts out idle */
+            atomic_store(&ring->wait.cons_waiting, 1);
+        }
         
         /*
-         * Allocate the circular buffer array
-         * calloc() initializes all elements to 0, which is helpful for debugging
-         * In production, you might use malloc() for slightly better performance
+         * Locate the circular buffer array: directly behind the structure in
+         * the same block, or the double mapping from spsc_magic_map()
          */
-        ring->buf  = calloc(capacity, sizeof(int));
-        if(!ring->buf)
+        int *buf = (flags & SPSC_RING_MAGIC) ? spsc_magic_map((uint64_t)capacity * sizeof(int), flags)
+                                             : (int *)(void *)(ring + 1);
+        if(!buf)
         {
-            free(ring);
+#ifdef __linux__
+            if (ring->cfg.efd >= 0) close(ring->cfg.efd);
+#endif
+            spsc_ring_free_block(ring);
             return NULL;
         }
+        ring->cfg.buf_off = spsc_ring_buf_offset(ring, buf);
+        ring->cfg.storage = SPSC_RING_STORAGE_HEAP;
+
+        if (flags & SPSC_RING_SENTINEL)
+        {
+            /* Here every slot is read before it is written: mark all free */
+            for (uint32_t i = 0; i < capacity; ++i)
+            {
+                buf[i] = SPSC_RING_EMPTY_SLOT;
+            }
+        }
         
         /*
          * Initialize atomic head and tail pointers to 0
          * atomic_store() ensures these writes are visible to other threads
          * with proper memory ordering (default sequential consistency)
          * 
-         * Initial state: head = tail = 0 (empty buffer)
+         * Initial state: head = tail = 0 (empty buffer), and both cached
+         * copies agree with it
          */
-        atomic_store(&ring->head, 0);
-        atomic_store(&ring->tail, 0);
+        atomic_store(&ring->cons.head, 0);
+        atomic_store(&ring->prod.tail, 0);
+        ring->prod.local.cached_head = 0;
+        ring->cons.local.cached_tail = 0;
         
         /* Return pointer to the ring instance */
         return ring;
     }
 }
 
+/*
+ * NUMA-Aware Ring Initialization
+ * ==============================
+ * 
+ * Like spsc_ring_init_ex(), but the ring's block (structure and slots) is
+ * bound to a NUMA node derived from the CPUs the two sides will run on,
+ * see spsc_ring_numa.c. The caller still pins its threads itself.
+ * 
+ * Parameters:
+ * - capacity:     Number of slots (power of 2)
+ * - producer_cpu: CPU the producer thread runs on
+ * - consumer_cpu: CPU the consumer thread runs on
+ * - flags:        As for spsc_ring_init_ex(), except SPSC_RING_MAGIC
+ *                 (spsc_ring_init_numa() passes 0)
+ * - placement:    SPSC_RING_NUMA_CONSUMER (spsc_ring_init_numa()),
+ *                 SPSC_RING_NUMA_PRODUCER or SPSC_RING_NUMA_INTERLEAVE
+ * 
+ * Returns:
+ * - Pointer to the new ring; on a machine without NUMA topology in sysfs
+ *   it is an ordinary (mapped, unbound) ring
+ * - NULL with errno = EINVAL (unknown CPU, placement or flag) or the
+ *   mmap()/mbind()/mlock() error
+ */
+spsc_ring_t *spsc_ring_init_numa(uint32_t capacity, int producer_cpu, int consumer_cpu)
+{
+    return spsc_ring_init_numa_ex(capacity, producer_cpu, consumer_cpu, 0, SPSC_RING_NUMA_CONSUMER);
+}
+
+spsc_ring_t *spsc_ring_init_numa_ex(uint32_t capacity, int producer_cpu, int consumer_cpu,
+                                    uint32_t flags, uint32_t placement)
+{
+    spsc_numa_policy_t policy;
+    if ((capacity == 0) || ((capacity & (capacity - 1)) != 0) ||
+        (flags & ~SPSC_RING_FLAGS_ALL) != 0 || (flags & SPSC_RING_MAGIC) ||
+        spsc_numa_policy_for(producer_cpu, consumer_cpu, placement, &policy) != 0)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+    return spsc_ring_init_heap(capacity, flags, &policy);
+}
+
+/*
+ * Ring Initialization In Caller-Provided Memory
+ * =============================================
+ * 
+ * Lays a ring out in memory the caller already owns (an arena block, a
+ * member of a per-thread structure, SPSC_RING_DECLARE_STATIC() storage)
+ * instead of allocating it: structure first, slots directly behind it, so
+ * the ring costs no allocation and no extra pointer to chase.
+ * 
+ * spsc_ring_required_size() returns the bytes needed for capacity slots,
+ * the same value as SPSC_RING_REQUIRED_SIZE() in spsc_ring_inline.h, or 0
+ * if capacity is not a power of 2.
+ * 
+ * Parameters:
+ * - mem:      Start of the block; must be aligned to SPSC_RING_CACHE_LINE
+ * - bytes:    Size of the block, at least spsc_ring_required_size(capacity)
+ * - capacity: Number of slots (power of 2)
+ * - flags:    0 or SPSC_RING_BLOCKING (spsc_ring_init_in() passes 0);
+ *             the eventfd and magic modes need resources the caller's
+ *             memory cannot hold
+ * 
+ * Returns:
+ * - Pointer to the ring, which is mem itself
+ * - NULL with errno = EINVAL on a misaligned or short block, a bad
+ *   capacity or an unsupported flag
+ * 
+ * Only the structure is written; the slots are left as they are, since
+ * every slot is written before it is ever read. spsc_ring_destroy() just
+ * drops the pointer: the block stays the caller's to reuse or free. The
+ * ring is private to this process (for rings shared between processes see
+ * spsc_ring_create_shm()).
+ */
+size_t spsc_ring_required_size(uint32_t capacity)
+{
+    if ((capacity == 0) || ((capacity & (capacity - 1)) != 0))
+    {
+        return 0;
+    }
+    return SPSC_RING_REQUIRED_SIZE(capacity);
+}
+
+spsc_ring_t *spsc_ring_init_in(void *mem, size_t bytes, uint32_t capacity)
+{
+    return spsc_ring_init_in_ex(mem, bytes, capacity, 0);
+}
+
+spsc_ring_t *spsc_ring_init_in_ex(void *mem, size_t bytes, uint32_t capacity, uint32_t flags)
+{
+    size_t need = spsc_ring_required_size(capacity);
+    if (mem == NULL || need == 0 || bytes < need ||
+        ((uintptr_t)mem % _Alignof(spsc_ring_t)) != 0 ||
+        (flags & ~SPSC_RING_BLOCKING) != 0)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    spsc_ring_t *ring = mem;
+    memset(ring, 0, sizeof(*ring));
+    spsc_ring_format_mapped(ring, capacity, flags, SPSC_RING_STORAGE_USER);
+    return ring;
+}
+
 /*
  * Ring Buffer Push Operation (Producer Function)
  * ==============================================
@@ -140,8 +365,9 @@ spsc_ring_t *spsc_ring_init(uint32_t capacity)
  * 
  * Algorithm Overview:
  * 1. Load current tail (producer's position) with relaxed ordering
- * 2. Load current head (consumer's position) with acquire ordering
- * 3. Check if buffer is full: (tail + 1) would equal head after wrapping
+ * 2. Check fullness against the producer's cached copy of head
+ * 3. Only if the cached copy says "full", reload head with acquire ordering
+ *    and refresh the cache
  * 4. If not full: store data at tail position and advance tail atomically
  * 
  * Parameters:
@@ -160,72 +386,25 @@ spsc_ring_t *spsc_ring_init(uint32_t capacity)
  *   updating tail pointer
  * 
  * Full Buffer Detection:
- * We check if (tail + 1) & mask == head & mask to detect fullness.
- * This means we sacrifice one slot to distinguish full from empty:
- * - Empty: head == tail
- * - Full: (tail + 1) == head (after wrapping)
+ * The ring is full when tail - head == size. Because head and tail are
+ * free-running, this never collides with the empty case (head == tail),
+ * so no slot has to be sacrificed.
  * 
  * Thread Safety:
  * - Safe for single producer thread
  * - Coordinates with single consumer through atomic head/tail
+ * 
+ * See spsc_ring_push_inline() in spsc_ring_inline.h for the implementation,
+ * which callers can also inline directly into their event loop.
  */
 int spsc_ring_push(spsc_ring_t *ring, int fd)
 {
-    /*
-     * Check if buffer is full
-     * Buffer is full when (tail + 1) would equal head after index wrapping
-     * We use bitwise AND with mask for efficient modulo operation
-     * 
-     * Why this works:
-     * - Empty condition: head == tail  
-     * - Full condition: (tail + 1) == head (modulo buffer size)
-     * - This sacrifices 1 buffer slot to distinguish these states
-     */
     if (ring == NULL)
     {
         return -1;  // Invalid ring buffer pointer
     }
-    
-    else if (spsc_ring_is_full(ring))
-    {
-        return -1;  // Buffer is full, cannot push
-    }
 
-    else
-    {
-        /*
-        * Load current tail position (where we'll write next)
-        * Use relaxed ordering because this thread owns the tail pointer
-        * and doesn't need synchronization when reading its own position
-        */
-        uint32_t t = atomic_load_explicit(&ring->tail, memory_order_relaxed);
-        
-        /*
-        * Load current head position (consumer's read position)
-        * Use acquire ordering to synchronize with consumer's release store
-        */
-        // uint32_t h = atomic_load_explicit(&ring->head, memory_order_acquire);
-    
-    
-        /*
-        * Store the data at the current tail position
-        * Apply mask to wrap the index within buffer bounds
-        * This is a regular (non-atomic) store because only producer writes to this slot
-        */
-        ring->buf[t & ring->mask] = fd;
-    
-        /*
-         * Advance the tail pointer atomically with release ordering
-         * Release ordering ensures that our buffer write above is visible
-         * to the consumer before this tail update becomes visible
-         * 
-         * This creates a happens-before relationship: buffer write → tail update
-         * Consumer will see tail update only after buffer write is complete
-         */
-        atomic_store_explicit(&ring->tail, t + 1, memory_order_release);
-    }
-    
-    return 0;  // Success
+    return spsc_ring_push_inline(ring, fd);
 }
 
 /*
@@ -237,8 +416,9 @@ int spsc_ring_push(spsc_ring_t *ring, int fd)
  * 
  * Algorithm Overview:
  * 1. Load current head (consumer's position) with relaxed ordering
- * 2. Load current tail (producer's position) with acquire ordering  
- * 3. Check if buffer is empty: head equals tail
+ * 2. Check emptiness against the consumer's cached copy of tail
+ * 3. Only if the cached copy says "empty", reload tail with acquire ordering
+ *    and refresh the cache
  * 4. If not empty: read data at head position and advance head atomically
  * 
  * Parameters:
@@ -257,107 +437,942 @@ int spsc_ring_push(spsc_ring_t *ring, int fd)
  *   before updating head pointer
  * 
  * Empty Buffer Detection:
- * We check if head & mask == tail & mask to detect emptiness.
- * When head equals tail (after wrapping), the buffer is empty.
+ * The ring is empty when head == tail (compared unmasked).
  * 
  * Thread Safety:
  * - Safe for single consumer thread  
  * - Coordinates with single producer through atomic head/tail
  * - Output parameter is not protected - caller must ensure exclusive access
+ * 
+ * See spsc_ring_pop_inline() in spsc_ring_inline.h for the implementation.
  */
 int spsc_ring_pop(spsc_ring_t *ring, int *out_fd)
 {
-    /*
-     * Load current head position (where we'll read next)
-     * Use relaxed ordering because this thread owns the head pointer
-     * and doesn't need synchronization when reading its own position
-     */
-    uint32_t h = atomic_load_explicit(&ring->head, memory_order_relaxed);
-    
-    /*
-     * Load current tail position (producer's write position)
-     * Use acquire ordering to synchronize with producer's release store
-     * This ensures we see all buffer writes the producer did before advancing tail
-     */
-    // uint32_t t = atomic_load_explicit(&ring->tail, memory_order_acquire);
-    
-    /*
-     * Check if buffer is empty
-     * Buffer is empty when head equals tail (after index wrapping)
-     * We use bitwise AND with mask for efficient modulo operation
-     * 
-     * Empty condition: head == tail
-     * This means consumer has caught up to producer
-     */
-    if (spsc_ring_is_empty(ring))
+    if (ring == NULL)
     {
-        return -1;  // Buffer is empty, cannot pop
+        return -1;  // Invalid ring buffer pointer
     }
-    
-    if (out_fd)
-    {
-        /*
-        * Read the data from current head position
-        * Apply mask to wrap the index within buffer bounds
-        * This is a regular (non-atomic) load because only consumer reads from this slot
-        * Store result in caller-provided output parameter
-        */
-        *out_fd = ring->buf[h & ring->mask];
-    }
-    
-    /*
-     * Advance the head pointer atomically with release ordering
-     * Release ordering ensures that our buffer read above completes
-     * before this head update becomes visible to the producer
-     * 
-     * This creates a happens-before relationship: buffer read → head update
-     * Producer will see head update only after buffer read is complete
-     * This allows producer to safely reuse this buffer slot
-     */
-    atomic_store_explicit(&ring->head, h + 1, memory_order_release);
-    
-    return 0;  // Success
+
+    return spsc_ring_pop_inline(ring, out_fd);
 }
 
+/*
+ * Ring Buffer Empty Check (Consumer Function)
+ * ===========================================
+ * 
+ * Reports whether the consumer has caught up with the producer.
+ * 
+ * The consumer's cached copy of tail is checked first. Only if it says the
+ * ring looks empty is the shared tail reloaded (acquire) and the cache
+ * refreshed, so a consumer draining a busy ring does not touch the
+ * producer's cache line at all.
+ * 
+ * Returns:
+ * - 1: Ring is empty
+ * - 0: At least one element is available
+ * 
+ * Thread Safety:
+ * - Must be called from the consumer thread: it updates the consumer's
+ *   private cached tail
+ */
 int spsc_ring_is_empty(spsc_ring_t *ring)
 {
-    /*
-     * Load current head position (where we'll read next)
-     * Use relaxed ordering because this thread owns the head pointer
-     * and doesn't need synchronization when reading its own position
-     */
-    uint32_t h = atomic_load_explicit(&ring->head, memory_order_relaxed);
-    
-    /*
-     * Load current tail position (producer's write position)
-     * Use acquire ordering to synchronize with producer's release store
-     * This ensures we see all buffer writes the producer did before advancing tail
-     */
-    uint32_t t = atomic_load_explicit(&ring->tail, memory_order_acquire);
-
-    return (h & ring->mask) == (t & ring->mask);
+    return spsc_ring_is_empty_inline(ring);
 }
 
+/*
+ * Ring Buffer Full Check (Producer Function)
+ * ==========================================
+ * 
+ * Reports whether the producer has run out of free slots.
+ * 
+ * Mirrors spsc_ring_is_empty(): the producer's cached copy of head is
+ * checked first and the shared head is reloaded (acquire) only when the
+ * cached copy says the ring looks full.
+ * 
+ * Returns:
+ * - 1: Ring is full
+ * - 0: At least one slot is free
+ * 
+ * Thread Safety:
+ * - Must be called from the producer thread: it updates the producer's
+ *   private cached head
+ */
 int spsc_ring_is_full(spsc_ring_t *ring)
 {
-    /*
-     * Load current head position (where we'll read next)
-     * Use relaxed ordering because this thread owns the head pointer
-     * and doesn't need synchronization when reading its own position
-     */
-    uint32_t h = atomic_load_explicit(&ring->head, memory_order_relaxed);
-    
-    /*
-     * Load current tail position (producer's write position)
-     * Use acquire ordering to synchronize with producer's release store
-     * This ensures we see all buffer writes the producer did before advancing tail
-     */
-    uint32_t t = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return spsc_ring_is_full_inline(ring);
+}
+
+/*
+ * Bulk Push Operation (Producer Function)
+ * =======================================
+ * 
+ * Copies up to n elements from src into the ring and publishes them with a
+ * single release store on tail, instead of one store per element as a loop
+ * around spsc_ring_push() would do.
+ * 
+ * Two flavours are provided:
+ * - spsc_ring_push_bulk():     best effort, pushes as many as fit
+ * - spsc_ring_push_bulk_all(): all or nothing, pushes n elements or none
+ * 
+ * The copy is done with at most two memcpy() segments, see
+ * spsc_ring_copy_in().
+ * 
+ * Parameters:
+ * - ring: Pointer to the ring buffer structure
+ * - src:  Array of at least n values to push
+ * - n:    Number of values requested
+ * 
+ * Returns:
+ * - spsc_ring_push_bulk():     number of elements pushed (0 if full or on
+ *                              invalid arguments)
+ * - spsc_ring_push_bulk_all(): 0 on success, -1 if fewer than n slots are
+ *                              free or on invalid arguments
+ * 
+ * Thread Safety:
+ * - Safe for single producer thread
+ */
+static uint32_t spsc_ring_push_n_sentinel(spsc_ring_t *ring, spsc_ring_prod_local_t *ps,
+                                          const int *src, uint32_t n, int all);
+
+static uint32_t spsc_ring_push_n(spsc_ring_t *ring, spsc_ring_prod_local_t *ps,
+                                 const int *src, uint32_t n, int all)
+{
+    if (ring->cfg.flags & SPSC_RING_SENTINEL)
+    {
+        return spsc_ring_push_n_sentinel(ring, ps, src, n, all);
+    }
+
+    uint64_t t    = ps->next;
+    uint32_t room = spsc_ring_prod_room(ring, ps, t, n);
 
-    return ((t + 1) & ring->mask) == (h & ring->mask);
+    if (room < n)
+    {
+        if (all) return 0;
+        n = room;
+    }
+    if (n == 0) return 0;
+
+    spsc_ring_copy_in(ring, ps, t, src, n);
+
+    /* One release store publishes the whole batch to the consumer */
+    spsc_ring_publish_tail(ring, ps, t + n);
+    spsc_ring_prefetch_prod(ring, ps, t, n);
+    return n;
 }
 
+uint32_t spsc_ring_push_bulk(spsc_ring_t *ring, const int *src, uint32_t n)
+{
+    if (ring == NULL || (src == NULL && n != 0))
+    {
+        return 0;
+    }
+    return spsc_ring_push_n(ring, &ring->prod.local, src, n, 0);
+}
 
+int spsc_ring_push_bulk_all(spsc_ring_t *ring, const int *src, uint32_t n)
+{
+    if (ring == NULL || (src == NULL && n != 0))
+    {
+        return -1;
+    }
+    return (spsc_ring_push_n(ring, &ring->prod.local, src, n, 1) == n) ? 0 : -1;
+}
+
+/*
+ * Bulk Pop Operation (Consumer Function)
+ * ======================================
+ * 
+ * Copies up to n elements from the ring into dst and hands the slots back
+ * to the producer with a single release store on head.
+ * 
+ * Two flavours are provided:
+ * - spsc_ring_pop_bulk():     best effort, pops whatever is available
+ * - spsc_ring_pop_bulk_all(): all or nothing, pops n elements or none
+ * 
+ * Parameters:
+ * - ring: Pointer to the ring buffer structure
+ * - dst:  Array with room for at least n values
+ * - n:    Number of values requested
+ * 
+ * Returns:
+ * - spsc_ring_pop_bulk():     number of elements popped (0 if empty or on
+ *                             invalid arguments)
+ * - spsc_ring_pop_bulk_all(): 0 on success, -1 if fewer than n elements
+ *                             are available or on invalid arguments
+ * 
+ * Thread Safety:
+ * - Safe for single consumer thread
+ */
+static uint32_t spsc_ring_pop_n_sentinel(spsc_ring_t *ring, spsc_ring_cons_local_t *cs,
+                                         int *dst, uint32_t n, int all);
+
+static uint32_t spsc_ring_pop_n(spsc_ring_t *ring, spsc_ring_cons_local_t *cs,
+                                int *dst, uint32_t n, int all)
+{
+    if (ring->cfg.flags & SPSC_RING_SENTINEL)
+    {
+        return spsc_ring_pop_n_sentinel(ring, cs, dst, n, all);
+    }
+
+    uint64_t h     = cs->next;
+    uint32_t ready = spsc_ring_cons_ready(ring, cs, h, n);
+
+    if (ready < n)
+    {
+        if (all) return 0;
+        n = ready;
+    }
+    if (n == 0) return 0;
+
+    spsc_ring_copy_out(ring, h, dst, n);
+
+    /* One release store returns the whole batch of slots to the producer */
+    spsc_ring_publish_head(ring, cs, h + n);
+    spsc_ring_prefetch_cons(ring, cs, h, n);
+    return n;
+}
+
+uint32_t spsc_ring_pop_bulk(spsc_ring_t *ring, int *dst, uint32_t n)
+{
+    if (ring == NULL || (dst == NULL && n != 0))
+    {
+        return 0;
+    }
+    return spsc_ring_pop_n(ring, &ring->cons.local, dst, n, 0);
+}
+
+int spsc_ring_pop_bulk_all(spsc_ring_t *ring, int *dst, uint32_t n)
+{
+    if (ring == NULL || (dst == NULL && n != 0))
+    {
+        return -1;
+    }
+    return (spsc_ring_pop_n(ring, &ring->cons.local, dst, n, 1) == n) ? 0 : -1;
+}
+
+/*
+ * Zero-Copy Reserve / Commit (Producer Functions)
+ * ===============================================
+ * 
+ * Lets the producer write directly into the ring's slots, e.g. by passing
+ * them to accept4() or a parser, instead of staging values on its own stack
+ * and copying them in through spsc_ring_push().
+ * 
+ * spsc_ring_reserve() hands out up to n free slots starting at tail as one
+ * or two spans: the second span is only non-empty when the reservation
+ * crosses the end of buf (never on SPSC_RING_MAGIC rings, where the first
+ * span always covers the whole reservation). Nothing is published: tail is untouched, so the
+ * consumer cannot see the slots until spsc_ring_commit() advances tail by
+ * the number of slots actually filled, with a single release store.
+ * 
+ * Parameters (reserve):
+ * - ring:   Pointer to the ring buffer structure
+ * - n:      Maximum number of slots wanted
+ * - first:  Receives the span starting at tail (required)
+ * - second: Receives the wrapped span at the start of buf; may be NULL to
+ *           ask for a single contiguous span only
+ * 
+ * Returns (reserve):
+ * - Number of slots reserved (first->len + second->len), 0 if the ring is
+ *   full or on invalid arguments
+ * 
+ * Parameters (commit):
+ * - ring: Pointer to the ring buffer structure
+ * - n:    Number of reserved slots to publish, counted from the start of
+ *         the first span; any remaining reserved slots are dropped
+ * 
+ * Returns (commit):
+ * - 0: Success
+ * - -1: n exceeds the outstanding reservation or ring is NULL
+ * 
+ * Thread Safety:
+ * - Producer thread only
+ * - A reservation replaces the previous one; do not mix spsc_ring_push()
+ *   or the bulk push calls with an outstanding reservation
+ */
+static uint32_t spsc_ring_reserve_local(spsc_ring_t *ring, spsc_ring_prod_local_t *ps, uint32_t n,
+                                        spsc_ring_span_t *first, spsc_ring_span_t *second)
+{
+    if (first == NULL || (ring->cfg.flags & SPSC_RING_SENTINEL))
+    {
+        return 0;
+    }
+
+    uint64_t t    = ps->next;
+    uint32_t room = spsc_ring_prod_room(ring, ps, t, n);
+    if (n > room) n = room;
+
+    uint32_t idx     = (uint32_t)(t & ring->cfg.mask);
+    uint32_t len1    = spsc_ring_first_run(ring, idx, n);
+    uint32_t len2    = (second != NULL) ? n - len1 : 0;
+
+    first->data = &spsc_ring_buf(ring)[idx];
+    first->len  = len1;
+    if (second != NULL)
+    {
+        second->data = spsc_ring_buf(ring);
+        second->len  = len2;
+    }
+
+    ps->reserved = len1 + len2;
+    return ps->reserved;
+}
+
+static int spsc_ring_commit_local(spsc_ring_t *ring, spsc_ring_prod_local_t *ps, uint32_t n)
+{
+    if (n > ps->reserved)
+    {
+        return -1;
+    }
+
+    ps->reserved = 0;
+    if (n == 0) return 0;
+
+    uint64_t t = ps->next;
+
+    /* Publish the slots the caller filled in place */
+    spsc_ring_publish_tail(ring, ps, t + n);
+    spsc_ring_prefetch_prod(ring, ps, t, n);
+    return 0;
+}
+
+uint32_t spsc_ring_reserve(spsc_ring_t *ring, uint32_t n,
+                           spsc_ring_span_t *first, spsc_ring_span_t *second)
+{
+    if (ring == NULL)
+    {
+        return 0;
+    }
+    return spsc_ring_reserve_local(ring, &ring->prod.local, n, first, second);
+}
+
+int spsc_ring_commit(spsc_ring_t *ring, uint32_t n)
+{
+    if (ring == NULL)
+    {
+        return -1;
+    }
+    return spsc_ring_commit_local(ring, &ring->prod.local, n);
+}
+
+/*
+ * In-Place Peek / Release (Consumer Functions)
+ * ============================================
+ * 
+ * Consumer-side mirror of spsc_ring_reserve()/spsc_ring_commit().
+ * 
+ * spsc_ring_peek() returns read-only views of up to max readable elements
+ * starting at head, as one or two spans (the second only when the readable
+ * run crosses the end of buf, which never happens on SPSC_RING_MAGIC
+ * rings). head is untouched, so the producer cannot
+ * reuse those slots while the consumer works on them, e.g. while it hands
+ * the first span straight to epoll_ctl() batching code.
+ * 
+ * spsc_ring_release() then gives n slots back to the producer with a single
+ * release store on head.
+ * 
+ * Parameters (peek):
+ * - ring:   Pointer to the ring buffer structure
+ * - max:    Maximum number of elements to expose
+ * - first:  Receives the span starting at head (required)
+ * - second: Receives the wrapped span at the start of buf; may be NULL to
+ *           ask for a single contiguous span only
+ * 
+ * Returns (peek):
+ * - Number of elements exposed (first->len + second->len), 0 if the ring
+ *   is empty or on invalid arguments
+ * 
+ * Parameters (release):
+ * - ring: Pointer to the ring buffer structure
+ * - n:    Number of elements to consume, counted from head
+ * 
+ * Returns (release):
+ * - 0: Success
+ * - -1: n exceeds the number of readable elements or ring is NULL
+ * 
+ * Thread Safety:
+ * - Consumer thread only
+ * - The spans stay valid until the corresponding elements are released
+ */
+static uint32_t spsc_ring_peek_local(spsc_ring_t *ring, spsc_ring_cons_local_t *cs, uint32_t max,
+                                     spsc_ring_cspan_t *first, spsc_ring_cspan_t *second)
+{
+    if (first == NULL || (ring->cfg.flags & SPSC_RING_SENTINEL))
+    {
+        return 0;
+    }
+
+    uint64_t h     = cs->next;
+    uint32_t ready = spsc_ring_cons_ready(ring, cs, h, max);
+    if (max > ready) max = ready;
+
+    uint32_t idx    = (uint32_t)(h & ring->cfg.mask);
+    uint32_t len1   = spsc_ring_first_run(ring, idx, max);
+    uint32_t len2   = (second != NULL) ? max - len1 : 0;
+
+    first->data = &spsc_ring_buf(ring)[idx];
+    first->len  = len1;
+    if (second != NULL)
+    {
+        second->data = spsc_ring_buf(ring);
+        second->len  = len2;
+    }
+
+    return len1 + len2;
+}
+
+static int spsc_ring_release_local(spsc_ring_t *ring, spsc_ring_cons_local_t *cs, uint32_t n)
+{
+    if (ring->cfg.flags & SPSC_RING_SENTINEL)
+    {
+        return -1;
+    }
+
+    uint64_t h = cs->next;
+    if (spsc_ring_cons_ready(ring, cs, h, n) < n)
+    {
+        return -1;  // Cannot release elements that were never produced
+    }
+    if (n == 0) return 0;
+
+    /* Hand the consumed slots back to the producer */
+    spsc_ring_publish_head(ring, cs, h + n);
+    spsc_ring_prefetch_cons(ring, cs, h, n);
+    return 0;
+}
+
+uint32_t spsc_ring_peek(spsc_ring_t *ring, uint32_t max,
+                        spsc_ring_cspan_t *first, spsc_ring_cspan_t *second)
+{
+    if (ring == NULL)
+    {
+        return 0;
+    }
+    return spsc_ring_peek_local(ring, &ring->cons.local, max, first, second);
+}
+
+int spsc_ring_release(spsc_ring_t *ring, uint32_t n)
+{
+    if (ring == NULL)
+    {
+        return -1;
+    }
+    return spsc_ring_release_local(ring, &ring->cons.local, n);
+}
+
+/*
+ * Deferred Index Publication
+ * ==========================
+ * 
+ * Every publish normally pays a release store on a line the other core
+ * reads, i.e. one cache-line transfer per element for a producer pushing
+ * one element at a time. spsc_ring_set_lazy() switches a ring to deferred
+ * publication in the style of MCRingBuffer: each side keeps advancing its
+ * private index and stores the shared one only once per batch.
+ * 
+ * - Producer: tail is published every tail_batch elements, on
+ *   spsc_ring_flush(), when the ring looks full, or when a push finds the
+ *   oldest unpublished element at least flush_after_ns old
+ * - Consumer: head is handed back every size / 4 elements, or as soon as
+ *   the consumer finds the ring empty
+ * 
+ * Only the producer knows what it has not published, so the age is looked
+ * at by its own pushes: the one that starts a batch and every one that
+ * crosses a multiple of SPSC_RING_LAZY_STRIDE (8) pending elements, i.e.
+ * one clock read per stride rather than per element. The tail is published
+ * within flush_after_ns or SPSC_RING_LAZY_STRIDE pushes, whichever comes
+ * later; a producer that goes idle with elements pending must call
+ * spsc_ring_flush(). Elements the producer has not published are invisible
+ * to the consumer, including to spsc_ring_pop_wait() and the eventfd.
+ * 
+ * Parameters (set_lazy):
+ * - tail_batch:     Elements per tail store (capped at the capacity); 0
+ *                   or 1 turns deferred publication off again
+ * - flush_after_ns: Age of the oldest pending element at which a push
+ *                   publishes, 0 for no time check
+ * 
+ * Returns (set_lazy): 0, or -1 with errno = EINVAL if ring is NULL or a
+ * SPSC_RING_SENTINEL ring (which has no index to defer). Call
+ * while neither side is running, like spsc_ring_set_spin(); switching it
+ * off publishes whatever is pending.
+ * 
+ * spsc_ring_flush() (producer only) publishes every element written so
+ * far. Returns 0, or -1 if ring is NULL.
+ */
+int spsc_ring_set_lazy(spsc_ring_t *ring, uint32_t tail_batch, uint64_t flush_after_ns)
+{
+    if (ring == NULL || (ring->cfg.flags & SPSC_RING_SENTINEL))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (tail_batch < 2)
+    {
+        ring->cfg.tail_batch = 0;
+        ring->cfg.head_batch = 0;
+        ring->cfg.lazy_ns    = 0;
+        ring->prod.local.lazy_since = 0;
+        spsc_ring_store_tail(ring, ring->prod.local.next);
+        spsc_ring_store_head(ring, ring->cons.local.next);
+        return 0;
+    }
+
+    ring->cfg.tail_batch = (tail_batch < ring->cfg.size) ? tail_batch : ring->cfg.size;
+    ring->cfg.head_batch = (ring->cfg.size / 4 > 1) ? ring->cfg.size / 4 : 0;
+    ring->cfg.lazy_ns    = flush_after_ns;
+    return 0;
+}
+
+static int spsc_ring_flush_local(spsc_ring_t *ring, spsc_ring_prod_local_t *ps)
+{
+    if (ring->cfg.flags & SPSC_RING_SENTINEL)
+    {
+        return 0;   /* Every push was published by its own slot store */
+    }
+
+    uint64_t t = ps->next;
+    if (atomic_load_explicit(&ring->prod.tail, memory_order_relaxed) != t)
+    {
+        ps->lazy_since = 0;
+        spsc_ring_store_tail(ring, t);
+    }
+    return 0;
+}
+
+int spsc_ring_flush(spsc_ring_t *ring)
+{
+    if (ring == NULL)
+    {
+        return -1;
+    }
+    return spsc_ring_flush_local(ring, &ring->prod.local);
+}
+
+/*
+ * Sentinel Ring Probing and Bulk Transfers
+ * ========================================
+ * 
+ * spsc_ring_set_probe() sets how far ahead a SPSC_RING_SENTINEL ring
+ * probes once the run of slots its side knows about is used up (see
+ * spsc_ring_sentinel_room() in spsc_ring_inline.h). 1, the default, is
+ * plain FastForward: each side checks the very next slot. Larger values
+ * give the B-Queue behaviour: a consumer on a nearly empty ring waits for
+ * a batch to build up instead of taking each element (and its cache line)
+ * the moment it lands, at the cost of up to log2(batch) extra probes when
+ * the ring is almost full or empty. Powers of two up to a few cache lines
+ * of slots (e.g. 64) are typical.
+ * 
+ * Parameters:
+ * - batch: Probe distance, 1 .. capacity (larger values are capped)
+ * 
+ * Returns: 0, or -1 with errno = EINVAL if ring is NULL, not a sentinel
+ * ring, or batch is 0. Call while neither side is running.
+ * 
+ * The bulk calls on a sentinel ring probe for their whole n at once and
+ * then store the slots one by one (each slot is its own publication).
+ * A best-effort push stops at the first SPSC_RING_EMPTY_SLOT in src; the
+ * all-or-nothing push pushes nothing if src holds one.
+ */
+int spsc_ring_set_probe(spsc_ring_t *ring, uint32_t batch)
+{
+    if (ring == NULL || !(ring->cfg.flags & SPSC_RING_SENTINEL) || batch == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    ring->cfg.probe = (batch < ring->cfg.size) ? batch : ring->cfg.size;
+    return 0;
+}
+
+static uint32_t spsc_ring_push_n_sentinel(spsc_ring_t *ring, spsc_ring_prod_local_t *ps,
+                                          const int *src, uint32_t n, int all)
+{
+    uint64_t t    = ps->next;
+    uint32_t room = spsc_ring_sentinel_room(ring, ps, t, all ? n : 1, n);
+
+    if (room < n)
+    {
+        if (all) return 0;
+        n = room;
+    }
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        if (src[i] == SPSC_RING_EMPTY_SLOT)
+        {
+            if (all) return 0;
+            n = i;
+            break;
+        }
+    }
+
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        atomic_store_explicit(spsc_ring_slot(ring, t + i), src[i], memory_order_release);
+    }
+    ps->next = t + n;
+    spsc_ring_prefetch_prod(ring, ps, t, n);
+    return n;
+}
+
+static uint32_t spsc_ring_pop_n_sentinel(spsc_ring_t *ring, spsc_ring_cons_local_t *cs,
+                                         int *dst, uint32_t n, int all)
+{
+    uint64_t h     = cs->next;
+    uint32_t ready = spsc_ring_sentinel_ready(ring, cs, h, all ? n : 1, n);
+
+    if (ready < n)
+    {
+        if (all) return 0;
+        n = ready;
+    }
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        _Atomic int *slot = spsc_ring_slot(ring, h + i);
+        dst[i] = atomic_load_explicit(slot, memory_order_relaxed);
+        atomic_store_explicit(slot, SPSC_RING_EMPTY_SLOT, memory_order_release);
+    }
+    cs->next = h + n;
+    spsc_ring_prefetch_cons(ring, cs, h, n);
+    return n;
+}
+
+/*
+ * Prefetch Distance
+ * =================
+ * 
+ * Sets how many slots ahead of its position each side prefetches (see
+ * spsc_ring_prefetch_prod() in spsc_ring_inline.h): the consumer hints the
+ * line it will read distance elements from now, the producer the line it
+ * will write, with write intent. It pays off when the slots are cold, i.e.
+ * rings larger than L2 or a consumer that runs well behind; on a ring
+ * that stays in cache it is a few wasted instructions per cache line of
+ * slots. Since a hint has to arrive before the line is needed, the right
+ * distance grows with the per-element work and shrinks with the element
+ * size; bench/spsc_ring_bench sweeps it.
+ * 
+ * Parameters:
+ * - distance: Slots ahead, 0 to turn prefetching off (the default);
+ *             capped at the capacity
+ * 
+ * Returns: 0, or -1 with errno = EINVAL if ring is NULL. Call while
+ * neither side is running.
+ */
+int spsc_ring_set_prefetch(spsc_ring_t *ring, uint32_t distance)
+{
+    if (ring == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (distance > ring->cfg.size) distance = ring->cfg.size;
+    ring->prod.local.prefetch = distance;
+    ring->cons.local.prefetch = distance;
+    return 0;
+}
+
+/*
+ * Streaming Bulk Pushes
+ * =====================
+ * 
+ * Bulk pushes (spsc_ring_push_bulk() and _all()) of at least min_bytes
+ * bytes write the slots with non-temporal stores (spsc_ring_copy_stream(),
+ * see spsc_ring_copy.c) instead of through the producer's cache. Worth it
+ * when single batches are large compared to the cache: they then no
+ * longer evict the producer's own working set, at the price of the
+ * consumer reading those slots from memory. Smaller pushes are unchanged.
+ * 
+ * Parameters:
+ * - min_bytes: Smallest batch, in bytes, that streams; 0 turns it off
+ *              (the default)
+ * 
+ * Returns: 0, or -1 with errno = EINVAL if ring is NULL or a
+ * SPSC_RING_SENTINEL ring (which stores slot by slot). Call while the
+ * producer is not running.
+ */
+int spsc_ring_set_stream(spsc_ring_t *ring, uint32_t min_bytes)
+{
+    if (ring == NULL || (ring->cfg.flags & SPSC_RING_SENTINEL))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    ring->prod.local.stream_min = min_bytes;
+    return 0;
+}
+
+/*
+ * Age check behind spsc_ring_defer_tail(): starts the clock on the first
+ * deferred element of a batch and reports whether flush_after_ns has
+ * passed since.
+ */
+int spsc_ring__lazy_expired(spsc_ring_t *ring, spsc_ring_prod_local_t *ps)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t ns = (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+
+    if (ps->lazy_since == 0)
+    {
+        ps->lazy_since = ns;
+        return 0;
+    }
+    return ns - ps->lazy_since >= ring->cfg.lazy_ns;
+}
+
+/*
+ * Endpoint Handles
+ * ================
+ * 
+ * A ring's producer and consumer share one spsc_ring_t, and with it the
+ * per-side state the library keeps next to the shared indices. An
+ * endpoint handle gives one side its own object instead:
+ * 
+ *   spsc_ring_producer_t *tx = spsc_ring_open_producer(ring);  // producer thread
+ *   spsc_ring_consumer_t *rx = spsc_ring_open_consumer(ring);  // consumer thread
+ * 
+ * Opening a side copies its private state (own index, cached peer index,
+ * prefetch distance, ...; spsc_ring_prod_local_t / spsc_ring_cons_local_t)
+ * out of the ring into the handle, which is allocated on a cache line of
+ * its own; every spsc_ring_producer_*() / spsc_ring_consumer_*() call then
+ * works on that copy. The ring's prod / cons lines keep only the shared
+ * indices until spsc_ring_close_producer() / spsc_ring_close_consumer()
+ * writes the state back, so open, work, close, and the ring-level calls
+ * pick up exactly where the handle left off.
+ * 
+ * The handle calls behave exactly like their ring-level namesakes
+ * (spsc_ring_producer_push() like spsc_ring_push(), ...) and cover every
+ * per-side call: push/pop, bulk, reserve/commit, peek/release, is_full /
+ * is_empty, flush, the blocking _wait / _wait_until forms and the eventfd
+ * drain. The two inline forms are spsc_ring_producer_push_inline() and
+ * spsc_ring_consumer_pop_inline() in spsc_ring_inline.h. The ring-level
+ * calls stay for code that never opens a handle.
+ * 
+ * Ownership:
+ * - Each side can be open at most once: a second open fails with EBUSY
+ *   until the first handle is closed
+ * - A handle belongs to the thread that uses it; open and close may happen
+ *   on another thread before / after it runs
+ * - While a side is open, do not call the ring-level functions of that
+ *   side (spsc_ring_push() while a producer is open, ...): they would work
+ *   on the ring's stale copy of the state
+ * - Settings that live in the side state (spsc_ring_set_prefetch(),
+ *   spsc_ring_set_stream()) are picked up on open; spsc_ring_set_lazy() and
+ *   spsc_ring_destroy() need both sides closed
+ * 
+ * Returns (open): the handle, or NULL with errno = EINVAL (ring is NULL),
+ * EBUSY (that side is already open) or ENOMEM.
+ * 
+ * Close takes a pointer to the handle pointer, sets it to NULL and
+ * accepts NULL, like spsc_ring_destroy().
+ */
+static int spsc_ring_endpoint_claim(spsc_ring_t *ring, uint32_t side)
+{
+    if (ring == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* Acquire: pairs with the release of the previous handle's close */
+    uint32_t bit = 1u << side;
+    if (atomic_fetch_or_explicit(&ring->wait.endpoints, bit, memory_order_acq_rel) & bit)
+    {
+        errno = EBUSY;
+        return -1;
+    }
+    return 0;
+}
+
+static void spsc_ring_endpoint_drop(spsc_ring_t *ring, uint32_t side)
+{
+    atomic_fetch_and_explicit(&ring->wait.endpoints, ~(1u << side), memory_order_release);
+}
+
+spsc_ring_producer_t *spsc_ring_open_producer(spsc_ring_t *ring)
+{
+    if (spsc_ring_endpoint_claim(ring, SPSC_RING_SIDE_PRODUCER) != 0)
+    {
+        return NULL;
+    }
+
+    spsc_ring_producer_t *prod = aligned_alloc(SPSC_RING_CACHE_LINE, sizeof(*prod));
+    if (prod == NULL)
+    {
+        spsc_ring_endpoint_drop(ring, SPSC_RING_SIDE_PRODUCER);
+        errno = ENOMEM;
+        return NULL;
+    }
+    prod->ring  = ring;
+    prod->local = ring->prod.local;
+    return prod;
+}
+
+spsc_ring_consumer_t *spsc_ring_open_consumer(spsc_ring_t *ring)
+{
+    if (spsc_ring_endpoint_claim(ring, SPSC_RING_SIDE_CONSUMER) != 0)
+    {
+        return NULL;
+    }
+
+    spsc_ring_consumer_t *cons = aligned_alloc(SPSC_RING_CACHE_LINE, sizeof(*cons));
+    if (cons == NULL)
+    {
+        spsc_ring_endpoint_drop(ring, SPSC_RING_SIDE_CONSUMER);
+        errno = ENOMEM;
+        return NULL;
+    }
+    cons->ring  = ring;
+    cons->local = ring->cons.local;
+    return cons;
+}
+
+void spsc_ring_close_producer(spsc_ring_producer_t **prod)
+{
+    if (prod && *prod)
+    {
+        spsc_ring_t *ring = (*prod)->ring;
+        ring->prod.local = (*prod)->local;
+        spsc_ring_endpoint_drop(ring, SPSC_RING_SIDE_PRODUCER);
+        free(*prod);
+        *prod = NULL;
+    }
+}
+
+void spsc_ring_close_consumer(spsc_ring_consumer_t **cons)
+{
+    if (cons && *cons)
+    {
+        spsc_ring_t *ring = (*cons)->ring;
+        ring->cons.local = (*cons)->local;
+        spsc_ring_endpoint_drop(ring, SPSC_RING_SIDE_CONSUMER);
+        free(*cons);
+        *cons = NULL;
+    }
+}
+
+int spsc_ring_producer_push(spsc_ring_producer_t *prod, int fd)
+{
+    if (prod == NULL)
+    {
+        return -1;
+    }
+    return spsc_ring_push_local(prod->ring, &prod->local, fd);
+}
+
+uint32_t spsc_ring_producer_push_bulk(spsc_ring_producer_t *prod, const int *src, uint32_t n)
+{
+    if (prod == NULL || (src == NULL && n != 0))
+    {
+        return 0;
+    }
+    return spsc_ring_push_n(prod->ring, &prod->local, src, n, 0);
+}
+
+int spsc_ring_producer_push_bulk_all(spsc_ring_producer_t *prod, const int *src, uint32_t n)
+{
+    if (prod == NULL || (src == NULL && n != 0))
+    {
+        return -1;
+    }
+    return (spsc_ring_push_n(prod->ring, &prod->local, src, n, 1) == n) ? 0 : -1;
+}
+
+uint32_t spsc_ring_producer_reserve(spsc_ring_producer_t *prod, uint32_t n,
+                                    spsc_ring_span_t *first, spsc_ring_span_t *second)
+{
+    if (prod == NULL)
+    {
+        return 0;
+    }
+    return spsc_ring_reserve_local(prod->ring, &prod->local, n, first, second);
+}
+
+int spsc_ring_producer_commit(spsc_ring_producer_t *prod, uint32_t n)
+{
+    if (prod == NULL)
+    {
+        return -1;
+    }
+    return spsc_ring_commit_local(prod->ring, &prod->local, n);
+}
+
+int spsc_ring_producer_is_full(spsc_ring_producer_t *prod)
+{
+    if (prod == NULL)
+    {
+        return -1;
+    }
+    return spsc_ring_is_full_local(prod->ring, &prod->local);
+}
+
+int spsc_ring_producer_flush(spsc_ring_producer_t *prod)
+{
+    if (prod == NULL)
+    {
+        return -1;
+    }
+    return spsc_ring_flush_local(prod->ring, &prod->local);
+}
+
+int spsc_ring_consumer_pop(spsc_ring_consumer_t *cons, int *out_fd)
+{
+    if (cons == NULL)
+    {
+        return -1;
+    }
+    return spsc_ring_pop_local(cons->ring, &cons->local, out_fd);
+}
+
+uint32_t spsc_ring_consumer_pop_bulk(spsc_ring_consumer_t *cons, int *dst, uint32_t n)
+{
+    if (cons == NULL || (dst == NULL && n != 0))
+    {
+        return 0;
+    }
+    return spsc_ring_pop_n(cons->ring, &cons->local, dst, n, 0);
+}
+
+int spsc_ring_consumer_pop_bulk_all(spsc_ring_consumer_t *cons, int *dst, uint32_t n)
+{
+    if (cons == NULL || (dst == NULL && n != 0))
+    {
+        return -1;
+    }
+    return (spsc_ring_pop_n(cons->ring, &cons->local, dst, n, 1) == n) ? 0 : -1;
+}
+
+uint32_t spsc_ring_consumer_peek(spsc_ring_consumer_t *cons, uint32_t max,
+                                 spsc_ring_cspan_t *first, spsc_ring_cspan_t *second)
+{
+    if (cons == NULL)
+    {
+        return 0;
+    }
+    return spsc_ring_peek_local(cons->ring, &cons->local, max, first, second);
+}
+
+int spsc_ring_consumer_release(spsc_ring_consumer_t *cons, uint32_t n)
+{
+    if (cons == NULL)
+    {
+        return -1;
+    }
+    return spsc_ring_release_local(cons->ring, &cons->local, n);
+}
+
+int spsc_ring_consumer_is_empty(spsc_ring_consumer_t *cons)
+{
+    if (cons == NULL)
+    {
+        return -1;
+    }
+    return spsc_ring_is_empty_local(cons->ring, &cons->local);
+}
 
 /*
  * Ring Buffer Cleanup Function
@@ -372,7 +1387,11 @@ int spsc_ring_is_full(spsc_ring_t *ring)
  *         After destruction, *ring will be set to NULL
  * 
  * Memory Safety:
- * - Frees the dynamically allocated buffer array
+ * - Frees the heap block holding the structure and its slots
+ * - Rings in caller-provided or ring-directory memory are not freed
+ * - Shared-memory rings are only unmapped from this process; the segment
+ *   itself lives on until spsc_ring_unlink_shm() and the last unmap
+ * - File-backed rings take a final checkpoint before they are unmapped
  * - Sets the caller's pointer to NULL to prevent accidental reuse
  * - Handles NULL pointers gracefully
  * 
@@ -395,12 +1414,37 @@ void spsc_ring_destroy(spsc_ring_t **ring)
      */
     if (ring && *ring)
     {
+        if ((*ring)->cfg.storage == SPSC_RING_STORAGE_SHM)
+        {
+            spsc_ring_shm_unmap(*ring);
+            *ring = NULL;
+            return;
+        }
+        if ((*ring)->cfg.storage == SPSC_RING_STORAGE_FILE)
+        {
+            spsc_ring_file_close(*ring);
+            *ring = NULL;
+            return;
+        }
+        if ((*ring)->cfg.storage == SPSC_RING_STORAGE_DIR ||
+            (*ring)->cfg.storage == SPSC_RING_STORAGE_USER)
+        {
+            *ring = NULL;   /* memory belongs to the directory / the caller */
+            return;
+        }
+
         /*
-         * Free the dynamically allocated buffer array
-         * This releases the memory that holds the actual ring data
+         * Heap slots live in the ring's own block and go with it below;
+         * only the double mapping of a magic ring is released separately
          */
-        free((*ring)->buf);
-        free(*ring);
+        if ((*ring)->cfg.flags & SPSC_RING_MAGIC)
+        {
+            spsc_magic_unmap(spsc_ring_buf(*ring), (uint64_t)(*ring)->cfg.size * sizeof(int));
+        }
+#ifdef __linux__
+        if ((*ring)->cfg.efd >= 0) close((*ring)->cfg.efd);
+#endif
+        spsc_ring_free_block(*ring);
         *ring = NULL;
     }
 }
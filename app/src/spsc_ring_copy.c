@@ -0,0 +1,238 @@
+/*
+ * SPSC Ring Buffer - Copy Kernels
+ * ===============================
+ *
+ * Bulk copies that should bypass the cache go through
+ * spsc_ring_copy_stream(), which forwards to the best non-temporal kernel
+ * this CPU supports, picked on first use with __builtin_cpu_supports():
+ *
+ * - avx512: 64-byte non-temporal stores
+ * - avx2:   32-byte non-temporal stores
+ * - sse2:   (every x86-64 CPU) 16-byte non-temporal stores
+ * - scalar: memcpy(), on any other target
+ *
+ * Cached copies are plain memcpy(): libc already picks a vectorised one
+ * for the CPU, and the ring fast paths call it directly, so a second
+ * dispatch layer in front of it only added an indirect call.
+ * spsc_ring_copy() is that memcpy(), kept so the two fit the same
+ * spsc_ring_copy_fn hooks.
+ *
+ * Streaming (non-temporal) copies write around the cache: the destination
+ * lines are not pulled into the producer's cache first and do not evict
+ * what the producer is working on. The catch is that the consumer then
+ * reads them from memory instead of from the producer's cache, so they
+ * only pay off for batches much larger than the cache (see
+ * spsc_ring_set_stream()). The partial lines at either end of the range
+ * are copied normally, and copies shorter than one vector go to memcpy().
+ * x86 does not order non-temporal stores with the release store that
+ * publishes them, so every streaming kernel ends with an sfence.
+ *
+ * spsc_ring_copy_select() pins a kernel by name (tests and benchmarks use
+ * it to compare them); it is process-wide.
+ */
+
+#include "spsc_ring.h"
+
+#include <errno.h>       /* errno, EINVAL, ENOTSUP */
+#include <stdatomic.h>   /* _Atomic, atomic_load_explicit */
+#include <stddef.h>      /* size_t */
+#include <stdint.h>      /* uint8_t, uintptr_t */
+#include <string.h>      /* memcpy, strcmp */
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SPSC_COPY_X86 1
+#include <immintrin.h>   /* AVX2 / AVX-512 / SSE2 intrinsics */
+#endif
+
+typedef struct spsc_copy_kernel {
+    const char        *name;
+    int              (*supported)(void);
+    spsc_ring_copy_fn  stream;        /* Non-temporal copy */
+} spsc_copy_kernel_t;
+
+static int spsc_copy_always(void)
+{
+    return 1;
+}
+
+static void *spsc_copy_scalar(void *restrict dst, const void *restrict src, size_t bytes)
+{
+    return memcpy(dst, src, bytes);
+}
+
+#ifdef SPSC_COPY_X86
+static int spsc_copy_has_avx2(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+static int spsc_copy_has_avx512(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f");
+}
+
+/* Bytes to copy normally before dst is aligned to align */
+static inline size_t spsc_copy_head(const void *dst, size_t align)
+{
+    return (size_t)(-(uintptr_t)dst & (uintptr_t)(align - 1));
+}
+
+__attribute__((target("sse2")))
+static void *spsc_copy_sse2_stream(void *restrict dst, const void *restrict src, size_t bytes)
+{
+    size_t head = spsc_copy_head(dst, 16);
+    if (bytes < head + 16)
+    {
+        return memcpy(dst, src, bytes);
+    }
+
+    uint8_t       *d = dst;
+    const uint8_t *s = src;
+    memcpy(d, s, head);
+    d     += head;
+    s     += head;
+    bytes -= head;
+    for (; bytes >= 16; d += 16, s += 16, bytes -= 16)
+    {
+        _mm_stream_si128((__m128i *)(void *)d, _mm_loadu_si128((const __m128i *)(const void *)s));
+    }
+    memcpy(d, s, bytes);
+    _mm_sfence();
+    return dst;
+}
+
+__attribute__((target("avx2")))
+static void *spsc_copy_avx2_stream(void *restrict dst, const void *restrict src, size_t bytes)
+{
+    size_t head = spsc_copy_head(dst, 32);
+    if (bytes < head + 32)
+    {
+        return memcpy(dst, src, bytes);
+    }
+
+    uint8_t       *d = dst;
+    const uint8_t *s = src;
+    memcpy(d, s, head);
+    d     += head;
+    s     += head;
+    bytes -= head;
+    for (; bytes >= 32; d += 32, s += 32, bytes -= 32)
+    {
+        _mm256_stream_si256((__m256i *)(void *)d,
+                            _mm256_loadu_si256((const __m256i *)(const void *)s));
+    }
+    memcpy(d, s, bytes);
+    _mm_sfence();
+    return dst;
+}
+
+__attribute__((target("avx512f")))
+static void *spsc_copy_avx512_stream(void *restrict dst, const void *restrict src, size_t bytes)
+{
+    size_t head = spsc_copy_head(dst, 64);
+    if (bytes < head + 64)
+    {
+        return memcpy(dst, src, bytes);
+    }
+
+    uint8_t       *d = dst;
+    const uint8_t *s = src;
+    memcpy(d, s, head);
+    d     += head;
+    s     += head;
+    bytes -= head;
+    for (; bytes >= 64; d += 64, s += 64, bytes -= 64)
+    {
+        _mm512_stream_si512((__m512i *)(void *)d, _mm512_loadu_si512((const void *)s));
+    }
+    memcpy(d, s, bytes);
+    _mm_sfence();
+    return dst;
+}
+#endif
+
+/* Best first */
+static const spsc_copy_kernel_t spsc_copy_kernels[] = {
+#ifdef SPSC_COPY_X86
+    { "avx512", spsc_copy_has_avx512, spsc_copy_avx512_stream },
+    { "avx2",   spsc_copy_has_avx2,   spsc_copy_avx2_stream   },
+    { "sse2",   spsc_copy_always,     spsc_copy_sse2_stream   },
+#endif
+    { "scalar", spsc_copy_always,     spsc_copy_scalar        },
+};
+
+#define SPSC_COPY_KERNELS (sizeof(spsc_copy_kernels) / sizeof(spsc_copy_kernels[0]))
+
+/* NULL until the first copy or spsc_ring_copy_select() */
+static _Atomic(const spsc_copy_kernel_t *) spsc_copy_active;
+
+static const spsc_copy_kernel_t *spsc_copy_best(void)
+{
+    for (size_t i = 0; i < SPSC_COPY_KERNELS; ++i)
+    {
+        if (spsc_copy_kernels[i].supported())
+        {
+            return &spsc_copy_kernels[i];
+        }
+    }
+    return &spsc_copy_kernels[SPSC_COPY_KERNELS - 1];
+}
+
+static const spsc_copy_kernel_t *spsc_copy_get(void)
+{
+    const spsc_copy_kernel_t *k = atomic_load_explicit(&spsc_copy_active, memory_order_relaxed);
+    if (k == NULL)
+    {
+        /* Racing first calls all pick the same kernel */
+        k = spsc_copy_best();
+        atomic_store_explicit(&spsc_copy_active, k, memory_order_relaxed);
+    }
+    return k;
+}
+
+void *spsc_ring_copy(void *restrict dst, const void *restrict src, size_t bytes)
+{
+    return memcpy(dst, src, bytes);
+}
+
+void *spsc_ring_copy_stream(void *restrict dst, const void *restrict src, size_t bytes)
+{
+    return spsc_copy_get()->stream(dst, src, bytes);
+}
+
+const char *spsc_ring_copy_kernel(void)
+{
+    return spsc_copy_get()->name;
+}
+
+/*
+ * Pins the kernel called name ("avx512", "avx2", "sse2", "scalar"), or
+ * goes back to the best supported one for NULL. Returns 0, or -1 with
+ * errno = EINVAL for an unknown name or ENOTSUP if this CPU lacks it.
+ * Call before the rings are in use.
+ */
+int spsc_ring_copy_select(const char *name)
+{
+    if (name == NULL)
+    {
+        atomic_store_explicit(&spsc_copy_active, spsc_copy_best(), memory_order_relaxed);
+        return 0;
+    }
+    for (size_t i = 0; i < SPSC_COPY_KERNELS; ++i)
+    {
+        if (strcmp(spsc_copy_kernels[i].name, name) == 0)
+        {
+            if (!spsc_copy_kernels[i].supported())
+            {
+                errno = ENOTSUP;
+                return -1;
+            }
+            atomic_store_explicit(&spsc_copy_active, &spsc_copy_kernels[i], memory_order_relaxed);
+            return 0;
+        }
+    }
+    errno = EINVAL;
+    return -1;
+}
@@ -0,0 +1,374 @@
+/*
+ * SPSC Ring Buffer - Ring Directories
+ * ===================================
+ *
+ * A ring directory is one named shared-memory segment that holds a whole
+ * set of named rings, for process pairs that talk over many SPSC rings at
+ * once. Instead of one shm_open()/mmap() (and one set of TLB entries) per
+ * ring, every ring is created in a single batch at startup, mapped with a
+ * single mmap() and found by name with spsc_ring_dir_lookup().
+ *
+ * Segment Layout (offsets from its start):
+ *
+ *   0          struct spsc_ring_dir   magic, version, layout hash, size
+ *              entry[count]           name -> ring offset table
+ *   ...        ring 0                 struct spsc_ring + int slots[cap]
+ *   ...        ring 1                 (each ring cache-line aligned and
+ *   ...                                padded to whole cache lines)
+ *
+ * Like a single shared-memory ring, the segment contains no pointers and
+ * may be mapped at a different address in every process.
+ *
+ * Huge Pages:
+ * Segments of at least one transparent huge page (spsc_pages_huge_size(),
+ * read from sysfs) are sized to a multiple of it, mapped at an address
+ * aligned to it and advised with MADV_HUGEPAGE, so with transparent huge
+ * pages enabled for shmem the whole directory is served by a few huge TLB
+ * entries. The advice is best-effort: without it
+ * the directory works the same on normal pages.
+ *
+ * Rings from a directory are used like any other ring (including the
+ * blocking calls when created with SPSC_RING_BLOCKING). Calling
+ * spsc_ring_destroy() on one only clears the caller's pointer; the memory
+ * goes away with spsc_ring_dir_destroy() and spsc_ring_unlink_shm().
+ *
+ * Errors are reported as NULL with errno set.
+ */
+
+#include "spsc_ring.h"
+#include "spsc_ring_dir.h"
+#include "spsc_ring_inline.h"
+#include "spsc_ring_internal.h"
+
+#include <errno.h>       /* errno, EINVAL, EAGAIN, ENOENT */
+#include <fcntl.h>       /* O_CREAT, O_EXCL, O_RDWR */
+#include <stdatomic.h>   /* C11 atomic operations and memory ordering */
+#include <stdint.h>      /* uint32_t, uint64_t, uintptr_t */
+#include <string.h>      /* strlen, strcmp, strncmp, memchr, memcpy */
+#include <sys/mman.h>    /* shm_open, mmap, munmap, madvise */
+#include <sys/stat.h>    /* fstat */
+#include <unistd.h>      /* ftruncate, close, sysconf */
+
+#define SPSC_DIR_MAGIC     0x5249445243505353ull   /* "SSPCRDIR" little-endian */
+#define SPSC_DIR_VERSION   1u
+
+typedef struct {
+    char     name[SPSC_RING_DIR_NAME_MAX];
+    uint64_t ring_off;       /* Offset of struct spsc_ring from the segment */
+    uint64_t bytes;          /* Ring structure plus slots, padded */
+} spsc_dir_entry_t;
+
+struct spsc_ring_dir {
+    _Atomic uint64_t magic;          /* SPSC_DIR_MAGIC once fully initialised */
+    uint32_t         version;        /* SPSC_DIR_VERSION */
+    uint32_t         count;          /* Number of entries */
+    uint64_t         map_bytes;      /* Total size of the segment */
+    uint64_t         layout_hash;    /* spsc_shm_layout_hash() of the creator */
+    spsc_dir_entry_t entry[];
+};
+
+static uint64_t spsc_dir_align(uint64_t value, uint64_t align)
+{
+    return (value + align - 1) & ~(align - 1);
+}
+
+static uint64_t spsc_dir_ring_bytes(uint32_t capacity)
+{
+    return spsc_dir_align(sizeof(spsc_ring_t) + (uint64_t)capacity * sizeof(int),
+                          SPSC_RING_CACHE_LINE);
+}
+
+static uint64_t spsc_dir_table_bytes(uint32_t count)
+{
+    return spsc_dir_align(sizeof(spsc_ring_dir_t) + (uint64_t)count * sizeof(spsc_dir_entry_t),
+                          _Alignof(spsc_ring_t));
+}
+
+static spsc_ring_t *spsc_dir_ring(spsc_ring_dir_t *dir, uint32_t i)
+{
+    return (spsc_ring_t *)(void *)((char *)dir + dir->entry[i].ring_off);
+}
+
+/*
+ * Maps the segment. Large segments get a huge-page-aligned address (by
+ * reserving an extra huge page of address space and trimming it) and the
+ * MADV_HUGEPAGE hint; both are best-effort.
+ */
+static void *spsc_dir_map(int fd, uint64_t bytes)
+{
+    uint64_t huge = spsc_pages_huge_size(1);
+    if (bytes < huge)
+    {
+        return mmap(NULL, (size_t)bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+
+    size_t span = (size_t)(bytes + huge);
+    char  *area = mmap(NULL, span, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (area == MAP_FAILED)
+    {
+        return MAP_FAILED;
+    }
+    char *aligned = (char *)spsc_dir_align((uint64_t)(uintptr_t)area, huge);
+    void *map = mmap(aligned, (size_t)bytes, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_FIXED, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        munmap(area, span);
+        return MAP_FAILED;
+    }
+    if (aligned > area)
+    {
+        munmap(area, (size_t)(aligned - area));
+    }
+    munmap(aligned + bytes, (size_t)(area + span - (aligned + bytes)));
+#ifdef MADV_HUGEPAGE
+    madvise(map, (size_t)bytes, MADV_HUGEPAGE);
+#endif
+    return map;
+}
+
+static int spsc_dir_specs_valid(const spsc_ring_dir_spec_t *specs, uint32_t count)
+{
+    if (specs == NULL || count == 0)
+    {
+        return 0;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const spsc_ring_dir_spec_t *s = &specs[i];
+        if (s->name == NULL || s->name[0] == '\0' ||
+            strlen(s->name) >= SPSC_RING_DIR_NAME_MAX ||
+            s->capacity == 0 || (s->capacity & (s->capacity - 1)) != 0 ||
+            (s->flags & ~SPSC_RING_BLOCKING) != 0)
+        {
+            return 0;
+        }
+        for (uint32_t j = 0; j < i; ++j)
+        {
+            if (strcmp(specs[j].name, s->name) == 0)
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/*
+ * Directory Creation
+ * ==================
+ *
+ * Creates the shared-memory object shm_name holding one empty ring per
+ * spec, in spec order. Fails with EEXIST if the object already exists.
+ *
+ * Parameters:
+ * - shm_name: Shared-memory object name (as for shm_open())
+ * - specs:    Name, capacity and flags of each ring; names must be unique,
+ *             non-empty and shorter than SPSC_RING_DIR_NAME_MAX
+ * - count:    Number of specs (at least 1)
+ *
+ * Returns:
+ * - The directory, mapped in this process
+ * - NULL on error (errno set; EINVAL for bad specs)
+ */
+spsc_ring_dir_t *spsc_ring_dir_create(const char *shm_name,
+                                      const spsc_ring_dir_spec_t *specs, uint32_t count)
+{
+    if (shm_name == NULL || !spsc_dir_specs_valid(specs, count))
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    uint64_t bytes = spsc_dir_table_bytes(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        bytes += spsc_dir_ring_bytes(specs[i].capacity);
+    }
+    long     page = sysconf(_SC_PAGESIZE);
+    uint64_t huge = spsc_pages_huge_size(1);
+    bytes = spsc_dir_align(bytes, (bytes >= huge) ? huge : (page > 0) ? (uint64_t)page : 4096u);
+
+    int fd = shm_open(shm_name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)bytes) != 0)
+    {
+        int err = errno;
+        close(fd);
+        shm_unlink(shm_name);
+        errno = err;
+        return NULL;
+    }
+    void *map = spsc_dir_map(fd, bytes);
+    int err = errno;
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        shm_unlink(shm_name);
+        errno = err;
+        return NULL;
+    }
+
+    /* ftruncate() zero-filled the segment: every index and flag is 0 */
+    spsc_ring_dir_t *dir = map;
+    dir->version     = SPSC_DIR_VERSION;
+    dir->count       = count;
+    dir->map_bytes   = bytes;
+    dir->layout_hash = spsc_shm_layout_hash();
+
+    uint64_t off = spsc_dir_table_bytes(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        spsc_dir_entry_t *e = &dir->entry[i];
+        memcpy(e->name, specs[i].name, strlen(specs[i].name) + 1);
+        e->ring_off = off;
+        e->bytes    = spsc_dir_ring_bytes(specs[i].capacity);
+        spsc_ring_format_mapped(spsc_dir_ring(dir, i), specs[i].capacity, specs[i].flags,
+                                SPSC_RING_STORAGE_DIR);
+        off += e->bytes;
+    }
+
+    atomic_store_explicit(&dir->magic, SPSC_DIR_MAGIC, memory_order_release);
+    return dir;
+}
+
+/*
+ * Directory Attach
+ * ================
+ *
+ * Maps an existing directory and validates its header and every entry
+ * (bounds, alignment, ring configuration) before handing it out.
+ *
+ * Returns:
+ * - The directory, mapped in this process
+ * - NULL on error (errno set; EAGAIN if the creator has not finished,
+ *   EINVAL if the segment is not a compatible directory)
+ */
+spsc_ring_dir_t *spsc_ring_dir_attach(const char *shm_name)
+{
+    if (shm_name == NULL)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    int fd = shm_open(shm_name, O_RDWR, 0);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return NULL;
+    }
+    if ((uint64_t)st.st_size < sizeof(spsc_ring_dir_t))
+    {
+        close(fd);
+        errno = (st.st_size == 0) ? EAGAIN : EINVAL;   /* creator still sizing it */
+        return NULL;
+    }
+
+    uint64_t bytes = (uint64_t)st.st_size;
+    void *map = spsc_dir_map(fd, bytes);
+    int err = errno;
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        errno = err;
+        return NULL;
+    }
+
+    spsc_ring_dir_t *dir = map;
+    err = 0;
+    if (atomic_load_explicit(&dir->magic, memory_order_acquire) != SPSC_DIR_MAGIC)
+    {
+        err = EAGAIN;
+    }
+    else if (dir->version != SPSC_DIR_VERSION || dir->map_bytes != bytes ||
+             dir->layout_hash != spsc_shm_layout_hash() || dir->count == 0 ||
+             spsc_dir_table_bytes(dir->count) > bytes)
+    {
+        err = EINVAL;
+    }
+    for (uint32_t i = 0; err == 0 && i < dir->count; ++i)
+    {
+        const spsc_dir_entry_t *e = &dir->entry[i];
+        if (memchr(e->name, '\0', sizeof(e->name)) == NULL ||
+            e->ring_off % _Alignof(spsc_ring_t) != 0 ||
+            e->ring_off < spsc_dir_table_bytes(dir->count) ||
+            e->bytes < sizeof(spsc_ring_t) || e->ring_off + e->bytes > bytes)
+        {
+            err = EINVAL;
+            break;
+        }
+        const spsc_ring_t *ring = spsc_dir_ring(dir, i);
+        if (ring->cfg.storage != SPSC_RING_STORAGE_DIR ||
+            !spsc_ring_mapped_cfg_ok(ring, SPSC_RING_BLOCKING) ||
+            spsc_dir_ring_bytes(ring->cfg.size) != e->bytes)
+        {
+            err = EINVAL;
+        }
+    }
+    if (err != 0)
+    {
+        munmap(map, (size_t)bytes);
+        errno = err;
+        return NULL;
+    }
+    return dir;
+}
+
+/*
+ * Directory Lookup
+ * ================
+ *
+ * Returns the ring registered under name, or NULL (errno = ENOENT, or
+ * EINVAL for NULL arguments). A linear scan over the entry table: meant
+ * for startup wiring, keep the returned pointer for the hot path.
+ */
+spsc_ring_t *spsc_ring_dir_lookup(spsc_ring_dir_t *dir, const char *name)
+{
+    if (dir == NULL || name == NULL)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+    for (uint32_t i = 0; i < dir->count; ++i)
+    {
+        if (strncmp(dir->entry[i].name, name, SPSC_RING_DIR_NAME_MAX) == 0)
+        {
+            return spsc_dir_ring(dir, i);
+        }
+    }
+    errno = ENOENT;
+    return NULL;
+}
+
+uint32_t spsc_ring_dir_count(spsc_ring_dir_t *dir)
+{
+    return (dir != NULL) ? dir->count : 0;
+}
+
+/*
+ * Directory Cleanup
+ * =================
+ *
+ * Unmaps the directory from this process and sets *dir to NULL. Rings
+ * looked up from it must not be used afterwards. The segment itself stays
+ * until spsc_ring_unlink_shm(shm_name) and the last unmap.
+ */
+void spsc_ring_dir_destroy(spsc_ring_dir_t **dir)
+{
+    if (dir && *dir)
+    {
+        munmap(*dir, (size_t)(*dir)->map_bytes);
+        *dir = NULL;
+    }
+}
@@ -0,0 +1,363 @@
+/*
+ * SPSC Ring Buffer - File-Backed Persistent Rings
+ * ===============================================
+ *
+ * spsc_ring_open_file() maps a regular file with the same self-describing
+ * segment layout as the shared-memory rings (header, ring, slots; see
+ * spsc_ring_shm.c) and runs the normal in-memory hot path on it: push and
+ * pop never touch the file system, the kernel writes dirty pages back in
+ * the background.
+ *
+ * Durability comes from checkpoints. spsc_ring_checkpoint() snapshots
+ * head and tail, flushes the slot data with msync() and only then writes
+ * and flushes a small checkpoint record in the header. On the next
+ * spsc_ring_open_file() of the same path the ring resumes from the latest
+ * intact checkpoint instead of starting empty:
+ * - elements consumed after that checkpoint are delivered again
+ *   (at-least-once), elements produced after it are lost
+ * - spsc_ring_destroy() takes a final checkpoint, so a clean shutdown
+ *   loses nothing
+ *
+ * Checkpoint records alternate between two slots in the header, each with
+ * a sequence number and a check word, so a write torn by power loss
+ * leaves the previous record usable.
+ *
+ * Checkpoints must be taken on the consumer thread (or while the ring is
+ * quiescent): with head held still, the producer can only write slots
+ * outside the [head, tail) window being persisted.
+ *
+ * The slots are written through the shared mapping, so whatever the
+ * producer stores reaches the file too, checkpoint or not. A producer that
+ * reused slots as soon as the consumer's live head passed them could thus
+ * overwrite the window the last checkpoint still points at, and a crash
+ * would resume from a record whose slots hold newer data. File-backed
+ * rings therefore carry SPSC_RING_DURABLE: the producer only reuses slots
+ * behind cons.durable, the head of the last checkpoint, which
+ * spsc_ring_checkpoint() advances once its record is on disk. A full ring
+ * stays full until the consumer checkpoints, so a consumer that expects
+ * the producer to keep up must checkpoint at least once per ring's worth
+ * of elements (spsc_ring_checkpoint_every()).
+ *
+ * The file is locked with flock() for as long as it is open, so only one
+ * process owns a persistent ring at a time; producer and consumer are two
+ * threads of that process.
+ *
+ * Errors are reported as NULL / -1 with errno set.
+ */
+
+#include "spsc_ring.h"
+#include "spsc_ring_inline.h"
+#include "spsc_ring_internal.h"
+
+#include <errno.h>       /* errno, EINVAL, EBUSY, EPROTO */
+#include <fcntl.h>       /* open, O_RDWR, O_CREAT, O_CLOEXEC */
+#include <stdatomic.h>   /* C11 atomic operations and memory ordering */
+#include <stdint.h>      /* uint32_t, uint64_t */
+#include <string.h>      /* memset */
+#include <sys/file.h>    /* flock */
+#include <sys/mman.h>    /* mmap, msync, munmap */
+#include <sys/stat.h>    /* fstat */
+#include <time.h>        /* clock_gettime */
+#include <unistd.h>      /* ftruncate, close, sysconf */
+
+static uint64_t spsc_ckpt_check(uint64_t head, uint64_t tail, uint64_t seq)
+{
+    return (head * 0x9e3779b97f4a7c15ull) ^ (tail + 0x632be59bd9b4e019ull) ^
+           (seq << 1) ^ SPSC_SHM_MAGIC;
+}
+
+/* Latest intact checkpoint record, NULL if there is none */
+static const spsc_shm_ckpt_t *spsc_ckpt_latest(const spsc_shm_hdr_t *hdr)
+{
+    const spsc_shm_ckpt_t *best = NULL;
+    for (int i = 0; i < 2; ++i)
+    {
+        const spsc_shm_ckpt_t *c = &hdr->ckpt[i];
+        if (c->seq != 0 && c->check == spsc_ckpt_check(c->head, c->tail, c->seq) &&
+            (best == NULL || c->seq > best->seq))
+        {
+            best = c;
+        }
+    }
+    return best;
+}
+
+static void spsc_ckpt_write(spsc_shm_hdr_t *hdr, uint64_t head, uint64_t tail)
+{
+    const spsc_shm_ckpt_t *latest = spsc_ckpt_latest(hdr);
+    uint64_t seq = (latest != NULL) ? latest->seq + 1 : 1;
+
+    /* Overwrite the older record; the newer one stays intact meanwhile */
+    spsc_shm_ckpt_t *c = &hdr->ckpt[seq & 1];
+    c->head  = head;
+    c->tail  = tail;
+    c->seq   = seq;
+    c->check = spsc_ckpt_check(head, tail, seq);
+}
+
+/* The header, with its checkpoint records, sits in the first page */
+static int spsc_ckpt_flush_header(spsc_shm_hdr_t *hdr)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    return msync(hdr, (page > 0) ? (size_t)page : 4096u, MS_SYNC);
+}
+
+static uint64_t spsc_file_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+/*
+ * Resume From Checkpoint
+ * ======================
+ *
+ * Puts a ring found in an existing file back into the state of its latest
+ * checkpoint and clears everything that only made sense for the process
+ * that had it open before (cached indices, reservations, waiting flags,
+ * side owners, eventfd).
+ */
+static int spsc_file_resume(spsc_ring_t *ring)
+{
+    spsc_shm_hdr_t        *hdr  = spsc_shm_hdr(ring);
+    const spsc_shm_ckpt_t *ckpt = spsc_ckpt_latest(hdr);
+    if (ckpt == NULL || ckpt->tail - ckpt->head > ring->cfg.size)
+    {
+        errno = EPROTO;
+        return -1;
+    }
+
+    atomic_store(&ring->cons.head, ckpt->head);
+    atomic_store(&ring->cons.durable, ckpt->head);
+    atomic_store(&ring->prod.tail, ckpt->tail);
+    ring->cfg.flags             |= SPSC_RING_DURABLE;
+    ring->cons.local.next        = ckpt->head;
+    ring->prod.local.next        = ckpt->tail;
+    ring->cons.local.cached_tail = ckpt->tail;
+    ring->prod.local.cached_head = ckpt->head;
+    ring->prod.local.reserved    = 0;
+    ring->prod.local.lazy_since  = 0;
+    atomic_store(&ring->wait.cons_waiting, 0);
+    atomic_store(&ring->wait.prod_waiting, 0);
+    atomic_store(&ring->wait.endpoints, 0);
+    for (int side = 0; side < 2; ++side)
+    {
+        atomic_store(&hdr->owner[side].pid, 0);
+    }
+    ring->cfg.efd = -1;
+    return 0;
+}
+
+/*
+ * Persistent Ring Open
+ * ====================
+ *
+ * Opens (creating it if needed) the file at path as a persistent ring.
+ *
+ * - New or empty file: it is sized for capacity slots and formatted as an
+ *   empty ring, and that state is flushed as checkpoint 1
+ * - Existing ring file: it is validated like a shared-memory segment and
+ *   resumed from its latest checkpoint; capacity must match the file's
+ *   or be 0 to take it from the file
+ * - A file whose creation was interrupted before the ring was fully laid
+ *   out is formatted again
+ *
+ * Parameters:
+ * - path:     File to open
+ * - capacity: Number of slots (power of 2), or 0 to reopen an existing
+ *             ring with its own capacity
+ *
+ * Returns:
+ * - Pointer to the ring inside this process's mapping
+ * - NULL on error: errno = EBUSY (another process has it open), EINVAL
+ *   (bad arguments or not a compatible ring file), EPROTO (no intact
+ *   checkpoint), or whatever open()/ftruncate()/mmap() reported
+ */
+spsc_ring_t *spsc_ring_open_file(const char *path, uint32_t capacity)
+{
+    if (path == NULL || (capacity & (capacity - 1)) != 0)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    spsc_ring_t *ring  = NULL;
+    void        *map   = MAP_FAILED;
+    uint64_t     bytes = 0;
+    int          err   = 0;
+
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+    {
+        err = (errno == EWOULDBLOCK) ? EBUSY : errno;
+        goto fail;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        err = errno;
+        goto fail;
+    }
+
+    int fresh = (st.st_size == 0);
+    if (fresh)
+    {
+        if (capacity == 0)
+        {
+            err = EINVAL;
+            goto fail;
+        }
+        bytes = spsc_shm_bytes(capacity);
+        if (ftruncate(fd, (off_t)bytes) != 0)
+        {
+            err = errno;
+            goto fail;
+        }
+    }
+    else
+    {
+        bytes = (uint64_t)st.st_size;
+    }
+
+    map = mmap(NULL, (size_t)bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        err = errno;
+        goto fail;
+    }
+
+    if (!fresh)
+    {
+        ring = spsc_shm_check(map, bytes, SPSC_RING_STORAGE_FILE);
+        if (ring == NULL && errno == EAGAIN && capacity != 0 &&
+            bytes == spsc_shm_bytes(capacity))
+        {
+            /* Creation never finished and we hold the lock: start over */
+            memset(map, 0, (size_t)bytes);
+            fresh = 1;
+        }
+        else if (ring == NULL)
+        {
+            err = EINVAL;
+            goto fail;
+        }
+        else if (capacity != 0 && ring->cfg.size != capacity)
+        {
+            err = EINVAL;
+            goto fail;
+        }
+        else if (spsc_file_resume(ring) != 0)
+        {
+            err = errno;
+            goto fail;
+        }
+    }
+
+    if (fresh)
+    {
+        ring = spsc_shm_format(map, capacity, SPSC_RING_DURABLE, SPSC_RING_STORAGE_FILE);
+        spsc_ckpt_write(spsc_shm_hdr(ring), 0, 0);
+        if (msync(map, (size_t)bytes, MS_SYNC) != 0)
+        {
+            err = errno;
+            goto fail;
+        }
+    }
+
+    ring->cfg.map_fd = fd;
+    spsc_shm_hdr(ring)->ckpt_ns = spsc_file_now_ns();
+    return ring;
+
+fail:
+    if (map != MAP_FAILED) munmap(map, (size_t)bytes);
+    close(fd);
+    errno = err;
+    return NULL;
+}
+
+/*
+ * Checkpoints (Consumer Functions)
+ * ================================
+ *
+ * spsc_ring_checkpoint() makes the current head/tail durable:
+ * 1. load head and tail (acquire)
+ * 2. msync() the whole mapping, so every slot in [head, tail) is on disk
+ * 3. write the next checkpoint record and msync() the header page
+ * 4. release the slots behind the new head to the producer (cons.durable)
+ * Returns 0, or -1 with errno = EINVAL (not a file-backed ring) or the
+ * msync() error.
+ *
+ * spsc_ring_checkpoint_every() is the periodic form for the consumer's
+ * loop: it checkpoints only if at least interval_ns have passed since the
+ * previous checkpoint (or the open). Returns 1 if it took a checkpoint,
+ * 0 if none was due, -1 on error.
+ *
+ * Both are consumer-side calls, see the top of this file.
+ */
+int spsc_ring_checkpoint(spsc_ring_t *ring)
+{
+    if (ring == NULL || ring->cfg.storage != SPSC_RING_STORAGE_FILE)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    spsc_shm_hdr_t *hdr = spsc_shm_hdr(ring);
+    uint64_t h = atomic_load_explicit(&ring->cons.head, memory_order_acquire);
+    uint64_t t = atomic_load_explicit(&ring->prod.tail, memory_order_acquire);
+
+    /* Data first: a record must never point at slots not yet on disk */
+    if (msync(hdr, (size_t)hdr->map_bytes, MS_SYNC) != 0)
+    {
+        return -1;
+    }
+    spsc_ckpt_write(hdr, h, t);
+    if (spsc_ckpt_flush_header(hdr) != 0)
+    {
+        return -1;
+    }
+
+    /* Only now may the producer overwrite what the old record pointed at */
+    atomic_store_explicit(&ring->cons.durable, h, memory_order_release);
+    hdr->ckpt_ns = spsc_file_now_ns();
+    return 0;
+}
+
+int spsc_ring_checkpoint_every(spsc_ring_t *ring, uint64_t interval_ns)
+{
+    if (ring == NULL || ring->cfg.storage != SPSC_RING_STORAGE_FILE)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (spsc_file_now_ns() - spsc_shm_hdr(ring)->ckpt_ns < interval_ns)
+    {
+        return 0;
+    }
+    return (spsc_ring_checkpoint(ring) == 0) ? 1 : -1;
+}
+
+/*
+ * spsc_ring_destroy() back end for SPSC_RING_STORAGE_FILE rings: publish
+ * whatever deferred publication still holds back, final checkpoint, then
+ * unmap and close (which also drops the flock()).
+ */
+void spsc_ring_file_close(spsc_ring_t *ring)
+{
+    spsc_shm_hdr_t *hdr = spsc_shm_hdr(ring);
+    int fd = ring->cfg.map_fd;
+
+    atomic_store_explicit(&ring->prod.tail, ring->prod.local.next, memory_order_release);
+    atomic_store_explicit(&ring->cons.head, ring->cons.local.next, memory_order_release);
+
+    spsc_ring_checkpoint(ring);
+    munmap(hdr, (size_t)hdr->map_bytes);
+    close(fd);
+}
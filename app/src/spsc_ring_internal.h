@@ -0,0 +1,215 @@
+#ifndef SPSC_RING_INTERNAL_H
+#define SPSC_RING_INTERNAL_H
+
+/*
+ * SPSC Ring Buffer - Library-Internal Declarations
+ * ================================================
+ * 
+ * Shared between the library's translation units only; not installed and
+ * not part of any public header.
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "spsc_ring.h"
+#include "spsc_ring_inline.h"
+
+/*
+ * Ring Storage Kinds
+ * ==================
+ * 
+ * Recorded in cfg.storage so that spsc_ring_destroy() can hand each ring
+ * back to whatever provided its memory.
+ * 
+ * - HEAP: structure and slots from the C allocator (spsc_ring_init_ex)
+ * - SHM:  one POSIX shared-memory mapping (spsc_ring_create_shm/attach_shm)
+ * - FILE: one shared mapping of a regular file (spsc_ring_open_file)
+ * - DIR:  one entry of a ring directory segment (spsc_ring_dir_create);
+ *         the directory owns the memory, destroy only drops the pointer
+ * - USER: caller-provided memory (spsc_ring_init_in); the caller owns it,
+ *         destroy only drops the pointer
+ * 
+ * HEAP and USER rings are private to one process; the others may be
+ * mapped by more than one.
+ */
+enum
+{
+    SPSC_RING_STORAGE_HEAP = 0,
+    SPSC_RING_STORAGE_SHM  = 1,
+    SPSC_RING_STORAGE_FILE = 2,
+    SPSC_RING_STORAGE_DIR  = 3,
+    SPSC_RING_STORAGE_USER = 4,
+};
+
+/* Byte offset that makes spsc_ring_buf(ring) return buf */
+static inline int64_t spsc_ring_buf_offset(const spsc_ring_t *ring, const void *buf)
+{
+    return (int64_t)((intptr_t)buf - (intptr_t)ring);
+}
+
+/*
+ * Initialises the configuration of an empty ring laid out in zero-filled
+ * mapped memory, with its slots directly behind the structure.
+ */
+static inline void spsc_ring_format_mapped(spsc_ring_t *ring, uint32_t capacity,
+                                           uint32_t flags, uint32_t storage)
+{
+    ring->cfg.buf_off = (int64_t)sizeof(spsc_ring_t);
+    ring->cfg.size    = capacity;
+    ring->cfg.mask    = capacity - 1;
+    ring->cfg.flags   = flags;
+    ring->cfg.spin    = SPSC_RING_DEFAULT_SPIN;
+    ring->cfg.efd     = -1;
+    ring->cfg.map_fd  = -1;
+    ring->cfg.storage = storage;
+    ring->cfg.probe   = 1;
+}
+
+/*
+ * Checks the configuration of a ring found in a mapping some other process
+ * wrote: the slots must sit directly behind the structure, mask must match
+ * a power-of-2 size and no flag outside flags_ok may be set, otherwise
+ * every push/pop would index outside the mapping. Returns 1 if it does.
+ */
+static inline int spsc_ring_mapped_cfg_ok(const spsc_ring_t *ring, uint32_t flags_ok)
+{
+    return ring->cfg.buf_off == (int64_t)sizeof(spsc_ring_t) &&
+           ring->cfg.size != 0 && (ring->cfg.size & (ring->cfg.size - 1)) == 0 &&
+           ring->cfg.mask == ring->cfg.size - 1 &&
+           (ring->cfg.flags & ~flags_ok) == 0;
+}
+
+/*
+ * Double-Mapped Slot Storage (spsc_ring_magic.c)
+ * ==============================================
+ * 
+ * spsc_magic_map() maps bytes bytes of fresh memory twice, back to back,
+ * and returns the base (NULL on failure); spsc_magic_unmap() releases
+ * both halves. bytes must satisfy spsc_magic_size_ok() (a multiple of the
+ * page size).
+ */
+int spsc_magic_size_ok(uint64_t bytes);
+
+void *spsc_magic_map(uint64_t bytes, uint32_t flags);
+
+void spsc_magic_unmap(void *base, uint64_t bytes);
+
+/*
+ * NUMA Placement (spsc_ring_numa.c)
+ * =================================
+ * 
+ * A memory policy for mbind(): mode is an MPOL_* value and nodes the node
+ * mask (bit n = node n, so at most 64 nodes). spsc_numa_policy_for()
+ * derives it from the producer/consumer CPUs and an SPSC_RING_NUMA_*
+ * placement; spsc_numa_bind() applies it to an untouched mapping.
+ */
+typedef struct spsc_numa_policy {
+    int      mode;
+    uint64_t nodes;
+} spsc_numa_policy_t;
+
+int spsc_numa_policy_for(int producer_cpu, int consumer_cpu, uint32_t placement,
+                         spsc_numa_policy_t *policy);
+
+int spsc_numa_bind(void *addr, uint64_t bytes, const spsc_numa_policy_t *policy);
+
+/*
+ * Page-Backed Heap Storage (spsc_ring_pages.c)
+ * ============================================
+ * 
+ * spsc_pages_map() maps a heap ring's block according to the
+ * SPSC_RING_PAGE_FLAGS bits of flags, binds it to numa unless that is NULL,
+ * and reports the mapped length in *mapped (NULL with errno set on
+ * failure); spsc_pages_unmap() releases it. spsc_pages_huge_size()
+ * returns the system's hugetlbfs (thp == 0) or transparent (thp != 0)
+ * huge page size.
+ */
+void *spsc_pages_map(uint64_t bytes, uint32_t flags, const spsc_numa_policy_t *numa,
+                     uint64_t *mapped);
+
+void spsc_pages_unmap(void *base, uint64_t mapped);
+
+uint64_t spsc_pages_huge_size(int thp);
+
+/*
+ * Mapped Segment Layout
+ * =====================
+ * 
+ * Shared-memory and file-backed rings use the same self-describing,
+ * position-independent segment (see spsc_ring_shm.c for the details):
+ * 
+ *   0                  spsc_shm_hdr_t
+ *   SPSC_SHM_RING_OFF  struct spsc_ring
+ *   + sizeof(ring)     int slots[capacity]
+ */
+#define SPSC_SHM_MAGIC   0x474e495243505353ull   /* "SSPCRING" little-endian */
+#define SPSC_SHM_VERSION 3u
+
+/*
+ * Owner of one side; pid 0 = unowned, > 0 = owning process, < 0 = process
+ * -pid is in the middle of spsc_ring_shm_claim() (and is replaced like a
+ * dead owner if it dies there)
+ */
+typedef struct {
+    _Atomic int32_t  pid;          /* Owning process */
+    uint32_t         pad;
+    _Atomic uint64_t start_time;   /* Its start time, in clock ticks since boot */
+    _Atomic uint64_t epoch;        /* Heartbeat counter */
+} spsc_shm_owner_t;
+
+/* Durable head/tail snapshot of file-backed rings (spsc_ring_file.c) */
+typedef struct {
+    uint64_t head;
+    uint64_t tail;
+    uint64_t seq;                  /* Checkpoint number, 0 = never written */
+    uint64_t check;                /* Detects a torn write of this record */
+} spsc_shm_ckpt_t;
+
+typedef struct {
+    _Atomic uint64_t magic;        /* SPSC_SHM_MAGIC once fully initialised */
+    uint32_t         version;      /* SPSC_SHM_VERSION */
+    uint32_t         capacity;     /* Number of slots */
+    uint32_t         elem_size;    /* Bytes per slot */
+    uint32_t         ring_off;     /* Offset of struct spsc_ring */
+    uint64_t         map_bytes;    /* Total size of the segment */
+    uint64_t         layout_hash;  /* spsc_shm_layout_hash() of the creator */
+    spsc_shm_owner_t owner[2];     /* Indexed by SPSC_RING_SIDE_* */
+    spsc_shm_ckpt_t  ckpt[2];      /* Alternating checkpoint records */
+    uint64_t         ckpt_ns;      /* CLOCK_MONOTONIC of the last checkpoint */
+} spsc_shm_hdr_t;
+
+/* The ring follows the header on its own cache line */
+#define SPSC_SHM_RING_OFF \
+    ((sizeof(spsc_shm_hdr_t) + _Alignof(spsc_ring_t) - 1) & ~(_Alignof(spsc_ring_t) - 1))
+
+static inline spsc_shm_hdr_t *spsc_shm_hdr(spsc_ring_t *ring)
+{
+    return (spsc_shm_hdr_t *)(void *)((char *)ring - SPSC_SHM_RING_OFF);
+}
+
+/* Fingerprint of struct spsc_ring and the segment header in this build */
+uint64_t spsc_shm_layout_hash(void);
+
+/* Segment size for capacity slots */
+uint64_t spsc_shm_bytes(uint32_t capacity);
+
+/* Lays out an empty ring in zero-filled memory and publishes the magic */
+spsc_ring_t *spsc_shm_format(void *map, uint32_t capacity, uint32_t flags, uint32_t storage);
+
+/* Validates a mapped segment; NULL with errno (EAGAIN/EINVAL) on mismatch */
+spsc_ring_t *spsc_shm_check(void *map, uint64_t bytes, uint32_t storage);
+
+/* Unmaps a SPSC_RING_STORAGE_SHM ring (spsc_ring_shm.c) */
+void spsc_ring_shm_unmap(spsc_ring_t *ring);
+
+/* Checkpoints, unmaps and closes a SPSC_RING_STORAGE_FILE ring (spsc_ring_file.c) */
+void spsc_ring_file_close(spsc_ring_t *ring);
+
+/* Waits for want free slots / any readable slot (spsc_ring_wait.c) */
+int spsc_ring_wait_room(spsc_ring_t *ring, spsc_ring_prod_local_t *ps, uint32_t want,
+                        int64_t timeout_ns);
+
+int spsc_ring_wait_ready(spsc_ring_t *ring, spsc_ring_cons_local_t *cs, int64_t timeout_ns);
+
+#endif // SPSC_RING_INTERNAL_H
@@ -0,0 +1,119 @@
+/*
+ * SPSC Ring Buffer - Double-Mapped ("Magic") Slot Storage
+ * =======================================================
+ *
+ * Backs a ring's slots with a memfd mapped twice, back to back, in one
+ * reserved range of address space:
+ *
+ *   base                     base + bytes               base + 2 * bytes
+ *   | slots 0 .. size-1      | slots 0 .. size-1 again  |
+ *
+ * A write through either half lands in the same physical page, so any
+ * window of up to size elements starting at any index is contiguous in
+ * virtual memory: bulk copies, reserve/peek spans and variable-length
+ * records never have to be split or padded at the end of the buffer.
+ *
+ * The period of the mapping is the slot array size, so that size must be
+ * a multiple of the page size (spsc_magic_size_ok()). Linux only
+ * (memfd_create); elsewhere the mode is unavailable and init fails.
+ *
+ * The page flags of spsc_ring_init_ex() apply to the mapping as well:
+ * SPSC_RING_POPULATE prefaults both halves, SPSC_RING_HUGEPAGE adds the
+ * MADV_HUGEPAGE hint (honoured only where shmem huge pages are enabled)
+ * and SPSC_RING_MLOCK locks the memory or fails the map.
+ */
+
+#define _GNU_SOURCE
+
+#include "spsc_ring_internal.h"
+
+#include <stddef.h>      /* size_t */
+
+#ifdef __linux__
+#include <sys/mman.h>    /* memfd_create, mmap, munmap, madvise, mlock */
+#include <unistd.h>      /* ftruncate, close, sysconf */
+#endif
+
+int spsc_magic_size_ok(uint64_t bytes)
+{
+#ifdef __linux__
+    long page = sysconf(_SC_PAGESIZE);
+    return page > 0 && bytes != 0 && bytes % (uint64_t)page == 0 && bytes <= SIZE_MAX / 2;
+#else
+    (void)bytes;
+    return 0;
+#endif
+}
+
+/*
+ * Returns the base of the double mapping of bytes bytes, or NULL if the
+ * size is not page-aligned or any step fails. The memfd is closed again
+ * right away; the two mappings keep the memory alive. flags carries the
+ * ring's SPSC_RING_* init flags.
+ */
+void *spsc_magic_map(uint64_t bytes, uint32_t flags)
+{
+#ifdef __linux__
+    if (!spsc_magic_size_ok(bytes))
+    {
+        return NULL;
+    }
+
+    int fd = memfd_create("spsc_ring", MFD_CLOEXEC);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)bytes) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    /* Reserve both halves at once so nothing else can land in between */
+    char *base = mmap(NULL, (size_t)(2 * bytes), PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        close(fd);
+        return NULL;
+    }
+    int mflags = MAP_SHARED | MAP_FIXED | ((flags & SPSC_RING_POPULATE) ? MAP_POPULATE : 0);
+    if (mmap(base, (size_t)bytes, PROT_READ | PROT_WRITE, mflags, fd, 0) == MAP_FAILED ||
+        mmap(base + bytes, (size_t)bytes, PROT_READ | PROT_WRITE, mflags, fd, 0) == MAP_FAILED)
+    {
+        munmap(base, (size_t)(2 * bytes));
+        close(fd);
+        return NULL;
+    }
+    close(fd);
+#ifdef MADV_HUGEPAGE
+    if (flags & SPSC_RING_HUGEPAGE)
+    {
+        madvise(base, (size_t)(2 * bytes), MADV_HUGEPAGE);
+    }
+#endif
+    if ((flags & SPSC_RING_MLOCK) && mlock(base, (size_t)(2 * bytes)) != 0)
+    {
+        munmap(base, (size_t)(2 * bytes));
+        return NULL;
+    }
+    return base;
+#else
+    (void)bytes;
+    (void)flags;
+    return NULL;
+#endif
+}
+
+void spsc_magic_unmap(void *base, uint64_t bytes)
+{
+#ifdef __linux__
+    if (base != NULL)
+    {
+        munmap(base, (size_t)(2 * bytes));
+    }
+#else
+    (void)base;
+    (void)bytes;
+#endif
+}
@@ -0,0 +1,272 @@
+/*
+ * SPSC Ring Buffer - Page-Backed Heap Storage
+ * ===========================================
+ *
+ * With SPSC_RING_HUGEPAGE, SPSC_RING_POPULATE or SPSC_RING_MLOCK,
+ * spsc_ring_init_ex() takes the ring's block (structure plus slots) from
+ * an anonymous mapping instead of aligned_alloc(), so that the pages
+ * behind a large ring can be chosen and faulted in up front rather than
+ * on the producer's first trip around the ring:
+ *
+ * - SPSC_RING_HUGEPAGE: first try MAP_HUGETLB, i.e. explicit huge pages
+ *   from the hugetlbfs pool (length rounded up to the default hugetlbfs
+ *   page size). If the pool is empty or not configured, fall back to
+ *   ordinary pages at an address aligned to the transparent huge page size
+ *   with the MADV_HUGEPAGE hint, which lets transparent huge pages back
+ *   the block where the kernel allows it
+ * - SPSC_RING_POPULATE: every page is write-faulted before init returns
+ *   (after the huge page hint and any NUMA binding, so the pages are
+ *   allocated with both already in force)
+ * - SPSC_RING_MLOCK: mlock() the block so it can never be paged out; this
+ *   one is not best-effort, since a ring that asked to be locked but is not
+ *   would bring the faults back. It fails with the mlock() error (usually
+ *   ENOMEM/EPERM from RLIMIT_MEMLOCK)
+ *
+ * spsc_ring_init_numa() maps its block here as well and binds it with
+ * spsc_numa_bind() (spsc_ring_numa.c) before the first page is touched.
+ *
+ * Page Sizes:
+ * Neither huge page size is assumed. spsc_pages_huge_size() reads the
+ * hugetlbfs default from "Hugepagesize:" in /proc/meminfo and the
+ * transparent huge page size from
+ * /sys/kernel/mm/transparent_hugepage/hpage_pmd_size (1 GiB or 16 MiB
+ * pages are not unusual off x86, and arm64 with 64 KiB base pages uses
+ * 512 MiB PMDs). Each falls back to the other, and to 2 MiB only when
+ * neither file can be read.
+ *
+ * Linux only; elsewhere these flags make init fail.
+ */
+
+#define _GNU_SOURCE
+
+#include "spsc_ring_internal.h"
+
+#include <stdatomic.h>   /* C11 atomic operations and memory ordering */
+#include <stddef.h>      /* size_t */
+
+#ifdef __linux__
+#include <errno.h>       /* errno */
+#include <stdio.h>       /* fopen, fgets, sscanf, fclose */
+#include <sys/mman.h>    /* mmap, munmap, madvise, mlock, MAP_HUGETLB */
+#include <unistd.h>      /* sysconf */
+#endif
+
+#define SPSC_PAGES_HUGE_DEFAULT (2u * 1024u * 1024u)   /* Only if nothing can be read */
+#define SPSC_PAGES_SMALL        4096u                  /* Only if sysconf() fails */
+
+static uint64_t spsc_pages_align(uint64_t value, uint64_t align)
+{
+    return (value + align - 1) & ~(align - 1);
+}
+
+#ifdef __linux__
+/* Huge page size in bytes from /proc/meminfo, 0 if unavailable */
+static uint64_t spsc_pages_read_meminfo(void)
+{
+    FILE *f = fopen("/proc/meminfo", "r");
+    if (f == NULL)
+    {
+        return 0;
+    }
+    char               line[128];
+    unsigned long long kb = 0;
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        if (sscanf(line, "Hugepagesize: %llu kB", &kb) == 1)
+        {
+            break;
+        }
+    }
+    fclose(f);
+    return (uint64_t)kb * 1024u;
+}
+
+/* Transparent huge page (PMD) size in bytes from sysfs, 0 if unavailable */
+static uint64_t spsc_pages_read_pmd_size(void)
+{
+    FILE *f = fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r");
+    if (f == NULL)
+    {
+        return 0;
+    }
+    unsigned long long bytes = 0;
+    if (fscanf(f, "%llu", &bytes) != 1)
+    {
+        bytes = 0;
+    }
+    fclose(f);
+    return (uint64_t)bytes;
+}
+
+static int spsc_pages_size_ok(uint64_t bytes)
+{
+    return bytes >= SPSC_PAGES_SMALL && (bytes & (bytes - 1)) == 0 && bytes <= SIZE_MAX / 2;
+}
+#endif
+
+/*
+ * Huge page size in bytes: the hugetlbfs default (what MAP_HUGETLB without
+ * a size flag hands out) when thp is 0, the transparent huge page size
+ * when thp is non-zero. Each falls back to the other source, then to
+ * 2 MiB. Read once per kind; racing first callers read the same files.
+ */
+uint64_t spsc_pages_huge_size(int thp)
+{
+    static _Atomic uint64_t cached[2];
+
+    uint64_t size = atomic_load_explicit(&cached[thp != 0], memory_order_relaxed);
+    if (size != 0)
+    {
+        return size;
+    }
+#ifdef __linux__
+    uint64_t first  = thp ? spsc_pages_read_pmd_size() : spsc_pages_read_meminfo();
+    uint64_t second = thp ? spsc_pages_read_meminfo() : spsc_pages_read_pmd_size();
+    size = spsc_pages_size_ok(first) ? first
+         : spsc_pages_size_ok(second) ? second : SPSC_PAGES_HUGE_DEFAULT;
+#else
+    size = SPSC_PAGES_HUGE_DEFAULT;
+#endif
+    atomic_store_explicit(&cached[thp != 0], size, memory_order_relaxed);
+    return size;
+}
+
+#ifdef __linux__
+/*
+ * Ordinary pages for the fallback. Blocks of at least one huge page are
+ * placed at a huge-page-aligned address (reserve an extra huge page of
+ * address space, trim both ends) so transparent huge pages can back them
+ * from the first byte.
+ */
+static void *spsc_pages_map_small(uint64_t bytes, int thp)
+{
+    int      mflags = MAP_PRIVATE | MAP_ANONYMOUS;
+    uint64_t huge   = spsc_pages_huge_size(1);
+    if (bytes < huge)
+    {
+        return mmap(NULL, (size_t)bytes, PROT_READ | PROT_WRITE, mflags, -1, 0);
+    }
+
+    size_t span = (size_t)(bytes + huge);
+    char  *area = mmap(NULL, span, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (area == MAP_FAILED)
+    {
+        return MAP_FAILED;
+    }
+    char *aligned = (char *)(uintptr_t)spsc_pages_align((uint64_t)(uintptr_t)area, huge);
+    if (aligned > area)
+    {
+        munmap(area, (size_t)(aligned - area));
+    }
+    munmap(aligned + bytes, (size_t)(area + span - (aligned + bytes)));
+
+    void *map = mmap(aligned, (size_t)bytes, PROT_READ | PROT_WRITE, mflags | MAP_FIXED, -1, 0);
+    if (map == MAP_FAILED)
+    {
+        munmap(aligned, (size_t)bytes);
+        return MAP_FAILED;
+    }
+#ifdef MADV_HUGEPAGE
+    if (thp)
+    {
+        madvise(map, (size_t)bytes, MADV_HUGEPAGE);
+    }
+#else
+    (void)thp;
+#endif
+    return map;
+}
+#endif
+
+/*
+ * Maps bytes bytes for a ring block as selected by the SPSC_RING_HUGEPAGE /
+ * SPSC_RING_POPULATE / SPSC_RING_MLOCK bits of flags and binds it to numa
+ * (NULL: no binding). Returns the base and stores the mapped length (what
+ * spsc_pages_unmap() needs) in *mapped, or returns NULL with errno set.
+ */
+void *spsc_pages_map(uint64_t bytes, uint32_t flags, const spsc_numa_policy_t *numa,
+                     uint64_t *mapped)
+{
+#ifdef __linux__
+    long     page     = sysconf(_SC_PAGESIZE);
+    int      hugepage = (flags & SPSC_RING_HUGEPAGE) != 0;
+    void    *map      = MAP_FAILED;
+    uint64_t step     = (page > 0) ? (uint64_t)page : SPSC_PAGES_SMALL;
+    uint64_t len      = spsc_pages_align(bytes, step);
+
+    if (hugepage)
+    {
+        uint64_t tlb  = spsc_pages_huge_size(0);
+        uint64_t huge = spsc_pages_align(bytes, tlb);
+        map = mmap(NULL, (size_t)huge, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (map != MAP_FAILED)
+        {
+            len  = huge;
+            step = tlb;
+        }
+        else
+        {
+            /* No hugetlbfs pages: transparent huge pages, best-effort */
+            uint64_t thp = spsc_pages_huge_size(1);
+            len = (bytes >= thp) ? spsc_pages_align(bytes, thp) : len;
+        }
+    }
+    if (map == MAP_FAILED)
+    {
+        map = spsc_pages_map_small(len, hugepage);
+        if (map == MAP_FAILED)
+        {
+            return NULL;
+        }
+    }
+
+    /* Nothing is touched yet, so every page is allocated under the policy */
+    if (numa != NULL && spsc_numa_bind(map, len, numa) != 0)
+    {
+        int err = errno;
+        munmap(map, (size_t)len);
+        errno = err;
+        return NULL;
+    }
+
+    if (flags & SPSC_RING_POPULATE)
+    {
+        /* Write-fault every page now; reading would only map the zero page */
+        for (uint64_t off = 0; off < len; off += step)
+        {
+            ((volatile char *)map)[off] = 0;
+        }
+    }
+
+    if ((flags & SPSC_RING_MLOCK) && mlock(map, (size_t)len) != 0)
+    {
+        int err = errno;
+        munmap(map, (size_t)len);
+        errno = err;
+        return NULL;
+    }
+
+    *mapped = len;
+    return map;
+#else
+    (void)bytes;
+    (void)flags;
+    (void)numa;
+    (void)mapped;
+    return NULL;
+#endif
+}
+
+void spsc_pages_unmap(void *base, uint64_t mapped)
+{
+#ifdef __linux__
+    if (base != NULL)
+    {
+        munmap(base, (size_t)mapped);   /* also drops any mlock() */
+    }
+#else
+    (void)base;
+    (void)mapped;
+#endif
+}
@@ -0,0 +1,585 @@
+/*
+ * SPSC Ring Buffer - Shared-Memory Rings
+ * ======================================
+ *
+ * Places a ring in a named POSIX shared-memory object so that the producer
+ * and the consumer can live in different processes. One process creates
+ * the segment with spsc_ring_create_shm(), the other maps it with
+ * spsc_ring_attach_shm(); both then use the normal spsc_ring_* calls on
+ * the returned pointer, exactly as two threads would.
+ *
+ * Segment Layout (one mapping, offsets from its start):
+ *
+ *   0              spsc_shm_hdr_t   versioned header, see below
+ *   ring_off       struct spsc_ring cache-line aligned, as on the heap
+ *   ring_off + sz  int slots[size]  cfg.buf_off = sizeof(struct spsc_ring)
+ *
+ * Nothing in the segment is a pointer: the slot array is found through
+ * cfg.buf_off relative to the ring, so every process may map the segment
+ * at a different address.
+ *
+ * Header:
+ * - magic:       SPSC_SHM_MAGIC, stored last (release) by the creator; an
+ *                attacher that does not see it yet fails with EAGAIN
+ * - version:     SPSC_SHM_VERSION, bumped on any incompatible change
+ * - capacity:    Slot count
+ * - elem_size:   sizeof(int), the slot type
+ * - ring_off:    Offset of struct spsc_ring in the segment
+ * - map_bytes:   Total segment size
+ * - layout_hash: Fingerprint of the struct spsc_ring layout of the
+ *                creating build (sizes, member offsets, cache-line size),
+ *                so binaries built with a different SPSC_RING_CACHE_LINE
+ *                or library version refuse to attach instead of
+ *                corrupting each other's indices
+ * - owner:       Per-side liveness, see below
+ * - ckpt:        Checkpoint records, used by file-backed rings
+ *                (spsc_ring_file.c), which share this layout
+ *
+ * Blocking:
+ * Created with SPSC_RING_BLOCKING (spsc_ring_create_shm_ex()), a shared
+ * ring supports spsc_ring_pop_wait()/spsc_ring_push_wait() between the two
+ * processes. The waiting flags sit in the ring's wait line inside the
+ * segment and are used as process-shared futex words (see
+ * spsc_ring_wait.c), so an idle peer sleeps in the kernel while a busy
+ * pair never leaves user space. The flags are part of the shared
+ * configuration: the attacher inherits them.
+ * SPSC_RING_EVENTFD is refused, since an eventfd belongs to one process.
+ *
+ * Liveness and Recovery:
+ * The header also records, per side, which process owns it: pid, the
+ * process start time (so a recycled pid is not mistaken for the owner) and
+ * a heartbeat epoch the owner bumps at its own pace. A consumer that finds
+ * the ring empty can then tell "nothing yet" from "producer gone" with
+ * spsc_ring_peer_alive(), and a hung-but-alive peer from a stalled epoch.
+ *
+ * A crashed producer never leaves a half-written slot visible: slots are
+ * only published by the release store on tail after they were written, so
+ * whatever it was writing beyond tail is simply overwritten later. A
+ * restarted process takes over the side with spsc_ring_shm_claim(), which
+ * checks head/tail and resets that side's private state, and the pipeline
+ * resumes with the elements still in the ring.
+ *
+ * Errors are reported as NULL / -1 with errno set (EINVAL for bad
+ * arguments or an incompatible segment, plus whatever shm_open(),
+ * ftruncate() or mmap() reported).
+ */
+
+#include "spsc_ring.h"
+#include "spsc_ring_inline.h"
+#include "spsc_ring_internal.h"
+
+#include <errno.h>       /* errno, EINVAL, EAGAIN, EBUSY, EPROTO */
+#include <fcntl.h>       /* O_CREAT, O_EXCL, O_RDWR */
+#include <signal.h>      /* kill */
+#include <stdio.h>       /* snprintf, fopen, fread */
+#include <stdatomic.h>   /* C11 atomic operations and memory ordering */
+#include <stddef.h>      /* offsetof */
+#include <stdint.h>      /* uint32_t, uint64_t */
+#include <stdlib.h>      /* strtoull */
+#include <string.h>      /* strchr, strrchr */
+#include <sys/mman.h>    /* shm_open, shm_unlink, mmap, munmap */
+#include <sys/stat.h>    /* fstat */
+#include <unistd.h>      /* ftruncate, close */
+
+uint64_t spsc_shm_layout_hash(void)
+{
+    const uint64_t parts[] = {
+        SPSC_SHM_VERSION,
+        SPSC_RING_CACHE_LINE,
+        sizeof(spsc_ring_t),
+        sizeof(spsc_shm_hdr_t),
+        sizeof(int),
+        offsetof(spsc_ring_t, cfg.buf_off),
+        offsetof(spsc_ring_t, cfg.size),
+        offsetof(spsc_ring_t, cfg.flags),
+        offsetof(spsc_ring_t, prod.tail),
+        offsetof(spsc_ring_t, prod.local.cached_head),
+        offsetof(spsc_ring_t, cons.head),
+        offsetof(spsc_ring_t, cons.local.cached_tail),
+        offsetof(spsc_ring_t, wait.cons_waiting),
+        offsetof(spsc_ring_t, wait.prod_waiting),
+    };
+
+    /* FNV-1a over the values */
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); ++i)
+    {
+        for (unsigned byte = 0; byte < 8; ++byte)
+        {
+            hash ^= (parts[i] >> (byte * 8)) & 0xffu;
+            hash *= 0x100000001b3ull;
+        }
+    }
+    return hash;
+}
+
+uint64_t spsc_shm_bytes(uint32_t capacity)
+{
+    return SPSC_SHM_RING_OFF + sizeof(spsc_ring_t) + (uint64_t)capacity * sizeof(int);
+}
+
+static spsc_ring_t *spsc_shm_ring(spsc_shm_hdr_t *hdr)
+{
+    return (spsc_ring_t *)(void *)((char *)hdr + SPSC_SHM_RING_OFF);
+}
+
+/*
+ * Segment Format / Check
+ * ======================
+ *
+ * Shared by the shared-memory and file-backed constructors.
+ *
+ * spsc_shm_format() lays out an empty ring in a freshly mapped, zero-filled
+ * segment (as left by ftruncate()) and publishes it by storing the magic
+ * last, with release ordering.
+ *
+ * spsc_shm_check() verifies that a mapped segment holds a ring this build
+ * can operate on: magic, version, slot size, layout hash, size and
+ * storage kind must all match, and the ring's own configuration must pass
+ * spsc_ring_mapped_cfg_ok() (slot offset, mask, and no flags beyond
+ * SPSC_RING_BLOCKING, or SPSC_RING_DURABLE for file rings). Returns the
+ * ring, or NULL with errno = EAGAIN (not initialised yet) or EINVAL
+ * (incompatible or corrupt). The caller owns the mapping either way.
+ */
+spsc_ring_t *spsc_shm_format(void *map, uint32_t capacity, uint32_t flags, uint32_t storage)
+{
+    spsc_shm_hdr_t *hdr  = map;
+    spsc_ring_t    *ring = spsc_shm_ring(hdr);
+    spsc_ring_format_mapped(ring, capacity, flags, storage);
+
+    hdr->version     = SPSC_SHM_VERSION;
+    hdr->capacity    = capacity;
+    hdr->elem_size   = (uint32_t)sizeof(int);
+    hdr->ring_off    = (uint32_t)SPSC_SHM_RING_OFF;
+    hdr->map_bytes   = spsc_shm_bytes(capacity);
+    hdr->layout_hash = spsc_shm_layout_hash();
+
+    /* Publish: everything above is visible to an attacher that sees magic */
+    atomic_store_explicit(&hdr->magic, SPSC_SHM_MAGIC, memory_order_release);
+    return ring;
+}
+
+spsc_ring_t *spsc_shm_check(void *map, uint64_t bytes, uint32_t storage)
+{
+    spsc_shm_hdr_t *hdr = map;
+    if (bytes < SPSC_SHM_RING_OFF + sizeof(spsc_ring_t))
+    {
+        errno = (bytes == 0) ? EAGAIN : EINVAL;
+        return NULL;
+    }
+    if (atomic_load_explicit(&hdr->magic, memory_order_acquire) != SPSC_SHM_MAGIC)
+    {
+        errno = EAGAIN;
+        return NULL;
+    }
+
+    spsc_ring_t *ring     = spsc_shm_ring(hdr);
+    uint32_t     flags_ok = (storage == SPSC_RING_STORAGE_FILE) ? SPSC_RING_DURABLE
+                                                                : SPSC_RING_BLOCKING;
+    if (hdr->version != SPSC_SHM_VERSION ||
+        hdr->elem_size != sizeof(int) ||
+        hdr->ring_off != SPSC_SHM_RING_OFF ||
+        hdr->layout_hash != spsc_shm_layout_hash() ||
+        hdr->capacity == 0 || (hdr->capacity & (hdr->capacity - 1)) != 0 ||
+        hdr->map_bytes != bytes || hdr->map_bytes != spsc_shm_bytes(hdr->capacity) ||
+        ring->cfg.size != hdr->capacity ||
+        ring->cfg.storage != storage ||
+        !spsc_ring_mapped_cfg_ok(ring, flags_ok))
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+    return ring;
+}
+
+
+/*
+ * Shared-Memory Ring Creation
+ * ===========================
+ *
+ * Creates the shared-memory object name (as for shm_open(): "/name", at
+ * most NAME_MAX bytes, no further slashes), sizes it for capacity int
+ * slots and initialises an empty ring in it. Fails with EEXIST if the
+ * object already exists, so two creators can never initialise the same
+ * segment over each other.
+ *
+ * The returned ring behaves like one from spsc_ring_init(); the calling
+ * process typically becomes one side and the attaching process the other.
+ *
+ * Parameters:
+ * - name:     Shared-memory object name
+ * - capacity: Number of slots, must be a power of 2
+ * - flags:    (spsc_ring_create_shm_ex() only) 0 or SPSC_RING_BLOCKING
+ *
+ * Returns:
+ * - Pointer to the ring inside this process's mapping
+ * - NULL on error (errno set)
+ */
+spsc_ring_t *spsc_ring_create_shm(const char *name, uint32_t capacity)
+{
+    return spsc_ring_create_shm_ex(name, capacity, 0);
+}
+
+spsc_ring_t *spsc_ring_create_shm_ex(const char *name, uint32_t capacity, uint32_t flags)
+{
+    if (name == NULL || capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        (flags & ~SPSC_RING_BLOCKING) != 0)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    uint64_t bytes = spsc_shm_bytes(capacity);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)bytes) != 0)
+    {
+        int err = errno;
+        close(fd);
+        shm_unlink(name);
+        errno = err;
+        return NULL;
+    }
+
+    void *map = mmap(NULL, (size_t)bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);   /* the mapping keeps the object alive */
+    if (map == MAP_FAILED)
+    {
+        shm_unlink(name);
+        errno = err;
+        return NULL;
+    }
+
+    /* ftruncate() zero-filled the segment: indices, flags and slots are 0 */
+    return spsc_shm_format(map, capacity, flags, SPSC_RING_STORAGE_SHM);
+}
+
+/*
+ * Shared-Memory Ring Attach
+ * =========================
+ *
+ * Maps an existing segment created by spsc_ring_create_shm() and checks
+ * that it holds a ring this build can operate on: magic, version, slot
+ * size, layout hash and size must all match.
+ *
+ * Returns:
+ * - Pointer to the ring inside this process's mapping
+ * - NULL on error (errno set; EAGAIN if the creator has not finished
+ *   initialising the segment yet, EINVAL if it is incompatible)
+ */
+spsc_ring_t *spsc_ring_attach_shm(const char *name)
+{
+    if (name == NULL)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return NULL;
+    }
+    if ((uint64_t)st.st_size < SPSC_SHM_RING_OFF + sizeof(spsc_ring_t))
+    {
+        close(fd);
+        errno = (st.st_size == 0) ? EAGAIN : EINVAL;   /* creator still sizing it */
+        return NULL;
+    }
+
+    size_t bytes = (size_t)st.st_size;
+    void *map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        errno = err;
+        return NULL;
+    }
+
+    spsc_ring_t *ring = spsc_shm_check(map, bytes, SPSC_RING_STORAGE_SHM);
+    if (ring == NULL)
+    {
+        err = errno;
+        munmap(map, bytes);
+        errno = err;
+        return NULL;
+    }
+    return ring;
+}
+
+/*
+ * Shared-Memory Ring Removal
+ * ==========================
+ *
+ * spsc_ring_unlink_shm() removes the name so no further process can
+ * attach; processes that already mapped the ring keep using it until they
+ * call spsc_ring_destroy(). Usually called by the creator, either once the
+ * peer has attached or at shutdown. Returns 0, or -1 with errno set.
+ *
+ * spsc_ring_shm_unmap() is spsc_ring_destroy()'s back end for
+ * SPSC_RING_STORAGE_SHM rings: it only drops this process's mapping.
+ */
+int spsc_ring_unlink_shm(const char *name)
+{
+    if (name == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return shm_unlink(name);
+}
+
+void spsc_ring_shm_unmap(spsc_ring_t *ring)
+{
+    spsc_shm_hdr_t *hdr = spsc_shm_hdr(ring);
+
+    /* A clean detach gives up the sides this process owns */
+    int32_t self = (int32_t)getpid();
+    for (uint32_t side = 0; side < 2; ++side)
+    {
+        int32_t owner = self;
+        atomic_compare_exchange_strong(&hdr->owner[side].pid, &owner, 0);
+    }
+    munmap(hdr, (size_t)hdr->map_bytes);
+}
+
+/*
+ * Process Identity
+ * ================
+ *
+ * A pid alone does not identify a process for long: after the owner dies
+ * the kernel may hand the same pid to an unrelated one. The start time
+ * (field 22 of /proc/<pid>/stat, clock ticks since boot) does, so both
+ * are recorded and compared.
+ *
+ * Returns 0 and the start time, or -1 if the process does not exist (or
+ * /proc is unavailable, in which case liveness falls back to the pid).
+ */
+static int spsc_proc_start_time(int32_t pid, uint64_t *start_time)
+{
+    char path[64];
+    char stat[512];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
+    {
+        return -1;
+    }
+    size_t len = fread(stat, 1, sizeof(stat) - 1, f);
+    fclose(f);
+    stat[len] = '\0';
+
+    /* comm (field 2) may contain spaces and ')', so start after the last ')' */
+    char *p = strrchr(stat, ')');
+    if (p == NULL)
+    {
+        return -1;
+    }
+    /* p + 2 is field 3; skip fields 3..21 */
+    p += 2;
+    for (int field = 3; field < 22 && p != NULL; ++field)
+    {
+        p = strchr(p, ' ');
+        if (p != NULL) ++p;
+    }
+    if (p == NULL)
+    {
+        return -1;
+    }
+    *start_time = strtoull(p, NULL, 10);
+    return 0;
+}
+
+static int spsc_owner_alive(spsc_shm_owner_t *owner)
+{
+    int32_t pid = atomic_load_explicit(&owner->pid, memory_order_acquire);
+    if (pid == 0)
+    {
+        return 0;
+    }
+    if (pid < 0)
+    {
+        /*
+         * Claim in progress by process -pid. Its start time is not
+         * recorded yet, so only the pid itself can tell whether the
+         * claimant died before finishing
+         */
+        return kill(-pid, 0) == 0 || errno == EPERM;
+    }
+    if (kill(pid, 0) != 0 && errno != EPERM)
+    {
+        return 0;
+    }
+
+    uint64_t now;
+    if (spsc_proc_start_time(pid, &now) != 0)
+    {
+        return 1;   /* No /proc: trust the pid */
+    }
+    return now == atomic_load_explicit(&owner->start_time, memory_order_relaxed);
+}
+
+static spsc_shm_owner_t *spsc_shm_owner(spsc_ring_t *ring, uint32_t side)
+{
+    if (ring == NULL || ring->cfg.storage != SPSC_RING_STORAGE_SHM || side > SPSC_RING_SIDE_CONSUMER)
+    {
+        return NULL;
+    }
+    return &spsc_shm_hdr(ring)->owner[side];
+}
+
+/*
+ * Side Claim and Recovery
+ * =======================
+ *
+ * Makes the calling process the owner of one side of a shared ring. Every
+ * process should claim its side after create/attach; the claim is what
+ * spsc_ring_peer_alive() reports on. spsc_ring_destroy() gives it up.
+ *
+ * If the side was owned by a process that is gone (crashed, killed), the
+ * claim is also the recovery routine for a restarted process:
+ * 1. head/tail are validated (0 <= tail - head <= size); a ring that
+ *    fails this is refused rather than "repaired" into losing data
+ * 2. the side's private state is rebuilt from the shared indices: the
+ *    cached opposite index is reloaded, an uncommitted spsc_ring_reserve()
+ *    is dropped, and a waiting flag or an open endpoint handle
+ *    (spsc_ring_open_producer()) left by the dead process is cleared
+ * 3. the ring then carries on from the published indices, keeping every
+ *    element that was in it. A consumer that died between peek and
+ *    release sees those elements again (at-least-once delivery).
+ *
+ * The claim marks the side with the claimant's own pid (negated) before
+ * it touches any state, so a process that dies halfway through its claim
+ * is recognised as gone and replaced the same way.
+ *
+ * Parameters:
+ * - ring: Shared ring from spsc_ring_create_shm()/spsc_ring_attach_shm()
+ * - side: SPSC_RING_SIDE_PRODUCER or SPSC_RING_SIDE_CONSUMER
+ *
+ * Returns:
+ * - 0: Side claimed, it was not owned before
+ * - 1: Side claimed after recovering it from a dead owner
+ * - -1: errno = EBUSY (a live process owns the side), EPROTO (head/tail
+ *   are inconsistent) or EINVAL
+ */
+int spsc_ring_shm_claim(spsc_ring_t *ring, uint32_t side)
+{
+    spsc_shm_owner_t *owner = spsc_shm_owner(ring, side);
+    if (owner == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    int32_t prev = atomic_load_explicit(&owner->pid, memory_order_acquire);
+    if (prev != 0 && spsc_owner_alive(owner))
+    {
+        errno = EBUSY;
+        return -1;
+    }
+    /* Negative pid: claim in progress, by us (see spsc_owner_alive()) */
+    int32_t self = (int32_t)getpid();
+    if (!atomic_compare_exchange_strong(&owner->pid, &prev, -self))
+    {
+        errno = EBUSY;   /* Another process claimed it first */
+        return -1;
+    }
+
+    uint64_t h = atomic_load_explicit(&ring->cons.head, memory_order_acquire);
+    uint64_t t = atomic_load_explicit(&ring->prod.tail, memory_order_acquire);
+    if (t - h > ring->cfg.size)
+    {
+        atomic_store_explicit(&owner->pid, prev, memory_order_release);
+        errno = EPROTO;
+        return -1;
+    }
+
+    /* A handle the dead owner had open on this side went with it */
+    atomic_fetch_and_explicit(&ring->wait.endpoints, ~(1u << side), memory_order_relaxed);
+    if (side == SPSC_RING_SIDE_PRODUCER)
+    {
+        ring->prod.local.next        = t;   /* a dead producer's unpublished elements are lost */
+        ring->prod.local.cached_head = h;
+        ring->prod.local.reserved    = 0;
+        ring->prod.local.lazy_since  = 0;
+        atomic_store_explicit(&ring->wait.prod_waiting, 0, memory_order_relaxed);
+    }
+    else
+    {
+        ring->cons.local.next        = h;   /* unreturned slots are read again */
+        ring->cons.local.cached_tail = t;
+        atomic_store_explicit(&ring->wait.cons_waiting, 0, memory_order_relaxed);
+    }
+
+    uint64_t start = 0;
+    spsc_proc_start_time(self, &start);
+    atomic_store_explicit(&owner->start_time, start, memory_order_relaxed);
+    atomic_fetch_add_explicit(&owner->epoch, 1, memory_order_relaxed);
+    atomic_store_explicit(&owner->pid, self, memory_order_release);
+    return (prev != 0) ? 1 : 0;
+}
+
+/*
+ * Liveness
+ * ========
+ *
+ * spsc_ring_shm_heartbeat() bumps the epoch of the caller's side; call it
+ * from the owning process at whatever interval suits the pipeline (e.g.
+ * once per batch or from a timer), never per element.
+ * Returns 0, or -1 (EINVAL) for a bad ring/side.
+ *
+ * spsc_ring_peer_alive() reports whether the owner of side still runs:
+ * 1 alive, 0 unowned or gone (the pid exited or now belongs to another
+ * process), -1 (EINVAL) for a bad ring/side.
+ *
+ * spsc_ring_peer_epoch() returns the heartbeat epoch of side (0 on
+ * error). An epoch that stops moving while the process is alive means the
+ * peer is stuck rather than dead.
+ */
+int spsc_ring_shm_heartbeat(spsc_ring_t *ring, uint32_t side)
+{
+    spsc_shm_owner_t *owner = spsc_shm_owner(ring, side);
+    if (owner == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    atomic_fetch_add_explicit(&owner->epoch, 1, memory_order_relaxed);
+    return 0;
+}
+
+int spsc_ring_peer_alive(spsc_ring_t *ring, uint32_t side)
+{
+    spsc_shm_owner_t *owner = spsc_shm_owner(ring, side);
+    if (owner == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return spsc_owner_alive(owner);
+}
+
+uint64_t spsc_ring_peer_epoch(spsc_ring_t *ring, uint32_t side)
+{
+    spsc_shm_owner_t *owner = spsc_shm_owner(ring, side);
+    if (owner == NULL)
+    {
+        return 0;
+    }
+    return atomic_load_explicit(&owner->epoch, memory_order_relaxed);
+}
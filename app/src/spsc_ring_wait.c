@@ -0,0 +1,572 @@
+/*
+ * SPSC Ring Buffer - Blocking Operations
+ * ======================================
+ *
+ * Spin-then-park versions of push/pop for rings created with
+ * spsc_ring_init_ex(capacity, SPSC_RING_BLOCKING).
+ *
+ * A waiting side first spins for a bounded budget (cfg.spin iterations,
+ * see spsc_ring_set_spin()), which keeps hand-off latency low on a busy
+ * ring. If the ring is still empty (consumer) or full (producer) it then
+ * publishes a "waiting" flag and parks on it as a futex word. The other
+ * side checks that flag after each index publication and only issues
+ * FUTEX_WAKE when it is set, so a ring under load never makes a syscall
+ * and an idle worker costs no CPU. See spsc_ring_publish_tail() in
+ * spsc_ring_inline.h for the wake-up protocol.
+ *
+ * Timeouts:
+ * - *_wait():       relative timeout in nanoseconds; < 0 waits forever,
+ *                   0 only tries once without spinning or parking
+ * - *_wait_until(): absolute CLOCK_MONOTONIC deadline; NULL waits forever
+ *
+ * Errors are reported as -1 with errno set:
+ * - EINVAL:    ring is NULL or was not created with SPSC_RING_BLOCKING
+ * - ETIMEDOUT: the deadline passed before the operation could complete
+ *
+ * Shared-memory rings (spsc_ring_create_shm_ex() with SPSC_RING_BLOCKING)
+ * use the same protocol across processes: the waiting flags live in the
+ * mapped segment and are waited on as process-shared futexes.
+ *
+ * Rings created with SPSC_RING_EVENTFD reuse the consumer's waiting flag
+ * for epoll-driven consumers: instead of parking on the futex, an idle
+ * consumer returns to its event loop and the producer writes the ring's
+ * eventfd when it publishes into a ring the consumer saw empty.
+ */
+
+#define _GNU_SOURCE
+
+#include "spsc_ring.h"
+#include "spsc_ring_inline.h"
+#include "spsc_ring_internal.h"
+
+#include <errno.h>       /* errno, EINVAL, ETIMEDOUT */
+#include <stdatomic.h>   /* C11 atomic operations and memory ordering */
+#include <stdint.h>      /* uint32_t, int64_t */
+#include <time.h>        /* clock_gettime, struct timespec */
+
+#ifdef __linux__
+#include <linux/futex.h> /* FUTEX_WAIT_BITSET, FUTEX_WAKE, FUTEX_BITSET_MATCH_ANY */
+#include <sys/syscall.h> /* SYS_futex */
+#include <unistd.h>      /* syscall, read, write */
+#endif
+
+#define SPSC_NSEC_PER_SEC 1000000000L
+
+static inline void spsc_ring_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+/*
+ * Futex Helpers
+ * =============
+ *
+ * spsc_futex_wait() sleeps while *word == expected, until woken or until
+ * the absolute CLOCK_MONOTONIC deadline (NULL = no deadline). FUTEX_WAIT
+ * takes a relative timeout, so the bitset variant is used: it takes an
+ * absolute one on CLOCK_MONOTONIC, which keeps repeated waits after
+ * spurious wake-ups anchored to the caller's original deadline.
+ *
+ * Returns -1 only on timeout. Wake-ups, EAGAIN (word already changed) and
+ * EINTR all return 0 and the caller re-checks the ring.
+ *
+ * Heap and caller-provided rings pass FUTEX_PRIVATE_FLAG, which lets the
+ * kernel key the wait on the virtual address alone. Words in a shared-memory or file-backed
+ * ring may be mapped at different addresses in each process, so for those
+ * the flag is dropped and the kernel keys the wait on the shared page.
+ */
+#ifdef __linux__
+static int spsc_futex_op(const spsc_ring_t *ring, int op)
+{
+    int private = (ring->cfg.storage == SPSC_RING_STORAGE_HEAP ||
+                   ring->cfg.storage == SPSC_RING_STORAGE_USER);
+    return private ? (op | FUTEX_PRIVATE_FLAG) : op;
+}
+#endif
+
+static int spsc_futex_wait(spsc_ring_t *ring, _Atomic uint32_t *word, uint32_t expected,
+                           const struct timespec *deadline)
+{
+#ifdef __linux__
+    long rc = syscall(SYS_futex, (uint32_t *)word,
+                      spsc_futex_op(ring, FUTEX_WAIT_BITSET), expected,
+                      deadline, NULL, FUTEX_BITSET_MATCH_ANY);
+    return (rc == -1 && errno == ETIMEDOUT) ? -1 : 0;
+#else
+    /* No futex: degrade to short sleeps, the caller re-checks the ring */
+    (void)ring;
+    (void)word;
+    (void)expected;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (deadline && (now.tv_sec > deadline->tv_sec ||
+                     (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec)))
+    {
+        return -1;
+    }
+    struct timespec nap = {0, 50000};
+    nanosleep(&nap, NULL);
+    return 0;
+#endif
+}
+
+static void spsc_futex_wake(spsc_ring_t *ring, _Atomic uint32_t *word)
+{
+#ifdef __linux__
+    syscall(SYS_futex, (uint32_t *)word, spsc_futex_op(ring, FUTEX_WAKE), 1, NULL, NULL, 0);
+#else
+    (void)ring;
+    (void)word;
+#endif
+}
+
+/*
+ * Wake-Up Slow Paths
+ * ==================
+ *
+ * Called by spsc_ring_publish_tail()/spsc_ring_publish_head() after they
+ * saw the peer's waiting flag set. The exchange makes sure that only one
+ * FUTEX_WAKE (or eventfd write) is issued per sleep, however many
+ * publishes race with it.
+ */
+void spsc_ring__wake_consumer(spsc_ring_t *ring)
+{
+    if (atomic_exchange_explicit(&ring->wait.cons_waiting, 0, memory_order_relaxed))
+    {
+#ifdef __linux__
+        if (ring->cfg.efd >= 0)
+        {
+            uint64_t one = 1;
+            ssize_t  rc  = write(ring->cfg.efd, &one, sizeof(one));
+            (void)rc;   /* EAGAIN: counter saturated, the fd is readable anyway */
+        }
+#endif
+        if (ring->cfg.flags & SPSC_RING_BLOCKING)
+        {
+            spsc_futex_wake(ring, &ring->wait.cons_waiting);
+        }
+    }
+}
+
+void spsc_ring__wake_producer(spsc_ring_t *ring)
+{
+    if (atomic_exchange_explicit(&ring->wait.prod_waiting, 0, memory_order_relaxed))
+    {
+        spsc_futex_wake(ring, &ring->wait.prod_waiting);
+    }
+}
+
+/*
+ * Eventfd Arming (Consumer Function)
+ * ==================================
+ *
+ * Called from spsc_ring_cons_ready() when a consumer on an
+ * SPSC_RING_EVENTFD ring finds it empty at head h. Declares the consumer
+ * idle with the same store / full fence / re-check sequence as the
+ * blocking wait, so a concurrent publish either sees the flag and writes
+ * the eventfd, or is seen here.
+ *
+ * Returns the number of readable elements after the re-check (0 if the
+ * ring is still empty and the eventfd is armed).
+ */
+uint32_t spsc_ring__arm_eventfd(spsc_ring_t *ring, spsc_ring_cons_local_t *cs, uint64_t h)
+{
+    atomic_store_explicit(&ring->wait.cons_waiting, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    cs->cached_tail = atomic_load_explicit(&ring->prod.tail, memory_order_acquire);
+    uint32_t ready = (uint32_t)(cs->cached_tail - h);
+    if (ready != 0)
+    {
+        /* Data raced in: disarm. A write the producer already made only
+         * costs the consumer one spurious, empty wake-up. */
+        atomic_store_explicit(&ring->wait.cons_waiting, 0, memory_order_relaxed);
+    }
+    return ready;
+}
+
+/*
+ * Eventfd Accessors
+ * =================
+ *
+ * spsc_ring_get_eventfd() returns the ring's eventfd for registration with
+ * epoll/poll/select (EPOLLIN), or -1 if ring is NULL or was not created
+ * with SPSC_RING_EVENTFD. The descriptor is owned by the ring and closed by
+ * spsc_ring_destroy().
+ *
+ * spsc_ring_eventfd_drain() resets the eventfd with a single read; call it
+ * from the consumer when the fd reports readable, then pop until the ring
+ * is empty. The pop that finds the ring empty re-arms the eventfd.
+ *
+ * Consumer loop:
+ *     epoll_wait(...)                      // fd readable
+ *     spsc_ring_eventfd_drain(ring);
+ *     while (spsc_ring_pop(ring, &v) == 0) handle(v);
+ *
+ * spsc_ring_eventfd_drain() returns 0 (also when nothing was pending), or
+ * -1 if ring is NULL or has no eventfd. spsc_ring_consumer_eventfd_drain()
+ * is the same on a consumer handle.
+ */
+int spsc_ring_get_eventfd(spsc_ring_t *ring)
+{
+    if (ring == NULL)
+    {
+        return -1;
+    }
+    return ring->cfg.efd;
+}
+
+int spsc_ring_eventfd_drain(spsc_ring_t *ring)
+{
+    if (ring == NULL || ring->cfg.efd < 0)
+    {
+        return -1;
+    }
+#ifdef __linux__
+    uint64_t count;
+    ssize_t  rc = read(ring->cfg.efd, &count, sizeof(count));
+    (void)rc;   /* EAGAIN: nothing pending, which is fine */
+#endif
+    return 0;
+}
+
+int spsc_ring_consumer_eventfd_drain(spsc_ring_consumer_t *cons)
+{
+    if (cons == NULL)
+    {
+        return -1;
+    }
+    return spsc_ring_eventfd_drain(cons->ring);
+}
+
+static int spsc_ring_can_pop(spsc_ring_t *ring, void *side)
+{
+    return !spsc_ring_is_empty_local(ring, side);
+}
+
+static int spsc_ring_can_push(spsc_ring_t *ring, void *side)
+{
+    return !spsc_ring_is_full_local(ring, side);
+}
+
+/*
+ * Spin-Then-Park Wait
+ * ===================
+ *
+ * Waits until ready(ring, side) is true (there is something to pop / room
+ * to push) or the deadline passes. side is the waiting side's private
+ * state (spsc_ring_prod_local_t / spsc_ring_cons_local_t).
+ *
+ * 1. Spin up to cfg.spin iterations with a CPU relax hint
+ * 2. Publish waiting = 1, full fence, re-check: the publisher either sees
+ *    the flag or we see its new index (see spsc_ring_publish_tail())
+ * 3. Park on the waiting word until the publisher clears it and wakes us,
+ *    then loop back to 2
+ *
+ * Returns 0 when ready, -1 on timeout.
+ */
+static int spsc_ring_wait_for(spsc_ring_t *ring, void *side, _Atomic uint32_t *waiting,
+                              int (*ready)(spsc_ring_t *, void *),
+                              const struct timespec *deadline)
+{
+    for (uint32_t i = 0; i < ring->cfg.spin; ++i)
+    {
+        if (ready(ring, side)) return 0;
+        spsc_ring_cpu_relax();
+    }
+
+    for (;;)
+    {
+        if (ready(ring, side)) return 0;
+
+        atomic_store_explicit(waiting, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (ready(ring, side))
+        {
+            atomic_store_explicit(waiting, 0, memory_order_relaxed);
+            return 0;
+        }
+
+        if (spsc_futex_wait(ring, waiting, 1, deadline) != 0)
+        {
+            atomic_store_explicit(waiting, 0, memory_order_relaxed);
+            return ready(ring, side) ? 0 : -1;
+        }
+    }
+}
+
+static int spsc_ring_deadline_from_ns(int64_t timeout_ns, struct timespec *deadline)
+{
+    if (clock_gettime(CLOCK_MONOTONIC, deadline) != 0)
+    {
+        return -1;
+    }
+    deadline->tv_sec  += (time_t)(timeout_ns / SPSC_NSEC_PER_SEC);
+    deadline->tv_nsec += (long)(timeout_ns % SPSC_NSEC_PER_SEC);
+    if (deadline->tv_nsec >= SPSC_NSEC_PER_SEC)
+    {
+        deadline->tv_sec  += 1;
+        deadline->tv_nsec -= SPSC_NSEC_PER_SEC;
+    }
+    return 0;
+}
+
+/*
+ * Spin Budget Setter
+ * ==================
+ *
+ * Sets how many iterations spsc_ring_push_wait()/spsc_ring_pop_wait() spin
+ * before parking. 0 parks immediately (lowest CPU use); larger values trade
+ * CPU for latency when the peer is expected to respond quickly.
+ *
+ * Returns 0, or -1 if ring is NULL. Call before the threads start.
+ */
+int spsc_ring_set_spin(spsc_ring_t *ring, uint32_t spins)
+{
+    if (ring == NULL)
+    {
+        return -1;
+    }
+    ring->cfg.spin = spins;
+    return 0;
+}
+
+/*
+ * Blocking Pop (Consumer Function)
+ * ================================
+ *
+ * Like spsc_ring_pop(), but waits for an element instead of failing on an
+ * empty ring.
+ *
+ * Returns:
+ * - 0: Success - element was popped and stored in *out_fd
+ * - -1: errno = ETIMEDOUT (nothing arrived in time) or EINVAL
+ *
+ * spsc_ring_consumer_pop_wait() / spsc_ring_consumer_pop_wait_until() are
+ * the same on an endpoint handle.
+ */
+static int spsc_ring_pop_wait_local(spsc_ring_t *ring, spsc_ring_cons_local_t *cs,
+                                    int *out_fd, const struct timespec *deadline)
+{
+    if (spsc_ring_wait_for(ring, cs, &ring->wait.cons_waiting, spsc_ring_can_pop, deadline) != 0)
+    {
+        errno = ETIMEDOUT;
+        return -1;
+    }
+    return spsc_ring_pop_local(ring, cs, out_fd);
+}
+
+static int spsc_ring_pop_wait_ns(spsc_ring_t *ring, spsc_ring_cons_local_t *cs,
+                                 int *out_fd, int64_t timeout_ns)
+{
+    if (timeout_ns < 0)
+    {
+        return spsc_ring_pop_wait_local(ring, cs, out_fd, NULL);
+    }
+    if (timeout_ns == 0)
+    {
+        if (spsc_ring_pop_local(ring, cs, out_fd) == 0) return 0;
+        errno = ETIMEDOUT;
+        return -1;
+    }
+
+    struct timespec deadline;
+    if (spsc_ring_deadline_from_ns(timeout_ns, &deadline) != 0)
+    {
+        return -1;
+    }
+    return spsc_ring_pop_wait_local(ring, cs, out_fd, &deadline);
+}
+
+int spsc_ring_pop_wait_until(spsc_ring_t *ring, int *out_fd, const struct timespec *deadline)
+{
+    if (ring == NULL || !(ring->cfg.flags & SPSC_RING_BLOCKING))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return spsc_ring_pop_wait_local(ring, &ring->cons.local, out_fd, deadline);
+}
+
+int spsc_ring_pop_wait(spsc_ring_t *ring, int *out_fd, int64_t timeout_ns)
+{
+    if (ring == NULL || !(ring->cfg.flags & SPSC_RING_BLOCKING))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return spsc_ring_pop_wait_ns(ring, &ring->cons.local, out_fd, timeout_ns);
+}
+
+int spsc_ring_consumer_pop_wait(spsc_ring_consumer_t *cons, int *out_fd, int64_t timeout_ns)
+{
+    if (cons == NULL || !(cons->ring->cfg.flags & SPSC_RING_BLOCKING))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return spsc_ring_pop_wait_ns(cons->ring, &cons->local, out_fd, timeout_ns);
+}
+
+int spsc_ring_consumer_pop_wait_until(spsc_ring_consumer_t *cons, int *out_fd,
+                                      const struct timespec *deadline)
+{
+    if (cons == NULL || !(cons->ring->cfg.flags & SPSC_RING_BLOCKING))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return spsc_ring_pop_wait_local(cons->ring, &cons->local, out_fd, deadline);
+}
+
+/*
+ * Blocking Push (Producer Function)
+ * =================================
+ *
+ * Like spsc_ring_push(), but waits for a free slot instead of failing on a
+ * full ring.
+ *
+ * Returns:
+ * - 0: Success - element was pushed
+ * - -1: errno = ETIMEDOUT (no slot freed in time) or EINVAL
+ *
+ * spsc_ring_producer_push_wait() / spsc_ring_producer_push_wait_until()
+ * are the same on an endpoint handle.
+ */
+static int spsc_ring_push_wait_local(spsc_ring_t *ring, spsc_ring_prod_local_t *ps,
+                                     int fd, const struct timespec *deadline)
+{
+    if (spsc_ring_wait_for(ring, ps, &ring->wait.prod_waiting, spsc_ring_can_push, deadline) != 0)
+    {
+        errno = ETIMEDOUT;
+        return -1;
+    }
+    return spsc_ring_push_local(ring, ps, fd);
+}
+
+static int spsc_ring_push_wait_ns(spsc_ring_t *ring, spsc_ring_prod_local_t *ps,
+                                  int fd, int64_t timeout_ns)
+{
+    if (timeout_ns < 0)
+    {
+        return spsc_ring_push_wait_local(ring, ps, fd, NULL);
+    }
+    if (timeout_ns == 0)
+    {
+        if (spsc_ring_push_local(ring, ps, fd) == 0) return 0;
+        errno = ETIMEDOUT;
+        return -1;
+    }
+
+    struct timespec deadline;
+    if (spsc_ring_deadline_from_ns(timeout_ns, &deadline) != 0)
+    {
+        return -1;
+    }
+    return spsc_ring_push_wait_local(ring, ps, fd, &deadline);
+}
+
+int spsc_ring_push_wait_until(spsc_ring_t *ring, int fd, const struct timespec *deadline)
+{
+    if (ring == NULL || !(ring->cfg.flags & SPSC_RING_BLOCKING))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return spsc_ring_push_wait_local(ring, &ring->prod.local, fd, deadline);
+}
+
+int spsc_ring_push_wait(spsc_ring_t *ring, int fd, int64_t timeout_ns)
+{
+    if (ring == NULL || !(ring->cfg.flags & SPSC_RING_BLOCKING))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return spsc_ring_push_wait_ns(ring, &ring->prod.local, fd, timeout_ns);
+}
+
+int spsc_ring_producer_push_wait(spsc_ring_producer_t *prod, int fd, int64_t timeout_ns)
+{
+    if (prod == NULL || !(prod->ring->cfg.flags & SPSC_RING_BLOCKING))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return spsc_ring_push_wait_ns(prod->ring, &prod->local, fd, timeout_ns);
+}
+
+int spsc_ring_producer_push_wait_until(spsc_ring_producer_t *prod, int fd,
+                                       const struct timespec *deadline)
+{
+    if (prod == NULL || !(prod->ring->cfg.flags & SPSC_RING_BLOCKING))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return spsc_ring_push_wait_local(prod->ring, &prod->local, fd, deadline);
+}
+
+/*
+ * Waits For Byte Records (spsc_msg_ring.c)
+ * ========================================
+ *
+ * The message ring runs on an int-slot spsc_ring_t but needs a record's
+ * worth of slots rather than one. spsc_ring_wait_room() waits until the
+ * producer state ps sees at least want free slots at ps->next,
+ * spsc_ring_wait_ready() until the consumer state cs sees anything at
+ * cs->next. timeout_ns as for spsc_ring_pop_wait().
+ *
+ * Returns 0, or -1 with errno = ETIMEDOUT. The caller checks for
+ * SPSC_RING_BLOCKING.
+ */
+typedef struct spsc_ring_want {
+    spsc_ring_prod_local_t *ps;
+    uint32_t                want;
+} spsc_ring_want_t;
+
+static int spsc_ring_has_room(spsc_ring_t *ring, void *side)
+{
+    spsc_ring_want_t *w = side;
+    return spsc_ring_prod_room(ring, w->ps, w->ps->next, w->want) >= w->want;
+}
+
+static int spsc_ring_wait_ns(spsc_ring_t *ring, void *side, _Atomic uint32_t *waiting,
+                             int (*ready)(spsc_ring_t *, void *), int64_t timeout_ns)
+{
+    struct timespec deadline;
+    if (timeout_ns == 0)
+    {
+        if (ready(ring, side)) return 0;
+    }
+    else if (timeout_ns < 0)
+    {
+        if (spsc_ring_wait_for(ring, side, waiting, ready, NULL) == 0) return 0;
+    }
+    else if (spsc_ring_deadline_from_ns(timeout_ns, &deadline) != 0)
+    {
+        return -1;
+    }
+    else if (spsc_ring_wait_for(ring, side, waiting, ready, &deadline) == 0)
+    {
+        return 0;
+    }
+    errno = ETIMEDOUT;
+    return -1;
+}
+
+int spsc_ring_wait_room(spsc_ring_t *ring, spsc_ring_prod_local_t *ps, uint32_t want,
+                        int64_t timeout_ns)
+{
+    spsc_ring_want_t w = { ps, want };
+    return spsc_ring_wait_ns(ring, &w, &ring->wait.prod_waiting, spsc_ring_has_room, timeout_ns);
+}
+
+int spsc_ring_wait_ready(spsc_ring_t *ring, spsc_ring_cons_local_t *cs, int64_t timeout_ns)
+{
+    return spsc_ring_wait_ns(ring, cs, &ring->wait.cons_waiting, spsc_ring_can_pop, timeout_ns);
+}
@@ -0,0 +1,432 @@
+/*
+ * SPSC Ring Buffer - Throughput Benchmark
+ * =======================================
+ *
+ * Moves items ints from a producer thread to a consumer thread, one
+ * element per call through the inline hot path, once per configuration,
+ * and reports million elements per second (best of runs):
+ *
+ * - index:          the default algorithm (shared head/tail, each side
+ *                   caching the other's index)
+ * - index-lazy:     the same with deferred publication,
+ *                   spsc_ring_set_lazy(capacity / 8, 0)
+ * - sentinel:       SPSC_RING_SENTINEL, FastForward (probe distance 1)
+ * - sentinel-probe: SPSC_RING_SENTINEL with B-Queue batched probing,
+ *                   spsc_ring_set_probe(capacity / 8)
+ *
+ * A second table sweeps the prefetch distance (spsc_ring_set_prefetch(),
+ * <name>_set_prefetch() of typed rings) over three element sizes: int
+ * slots and 64 / 256 byte records in SPSC_RING_DEFINE() rings. The
+ * distance only matters once the slots are cold, so give it a capacity
+ * whose slots exceed L2 (e.g. 1048576) to see it; the best distance moves
+ * down as the element size goes up.
+ * 
+ * A third table times the streaming copy kernels of spsc_ring_copy.c
+ * against memcpy() on their own, single-threaded, in GB/s: chunks of 64 B
+ * to 1 MiB written across a 64 MiB destination, so the streaming stores
+ * are compared against copies that really miss the cache.
+ * 
+ * Usage: spsc_ring_bench [items] [capacity] [producer_cpu consumer_cpu] [runs]
+ *
+ * Threads are pinned when CPUs are given (Linux). The modes differ in
+ * which cache lines cross between the two cores, so pick two CPUs on
+ * different physical cores (and, to see the worst case, different
+ * sockets); on a single CPU the numbers mostly measure the scheduler.
+ * The consumer checks the sequence, and a mismatch fails the run.
+ */
+
+#define _GNU_SOURCE
+
+#include "spsc_ring.h"
+#include "spsc_ring_inline.h"
+#include "spsc_ring_typed.h"
+
+#include <pthread.h>     /* pthread_create, pthread_join, pthread_setaffinity_np */
+#include <sched.h>       /* sched_yield, cpu_set_t */
+#include <stdatomic.h>   /* atomic_int */
+#include <stdint.h>      /* uint32_t, uint64_t */
+#include <stdio.h>       /* printf, fprintf */
+#include <stdlib.h>      /* strtoul, strtoull, strtol, malloc, free */
+#include <string.h>      /* memset */
+#include <time.h>        /* clock_gettime */
+
+/* Failed attempts in a row before a side yields its CPU */
+#define BENCH_SPIN_BEFORE_YIELD 1024u
+
+typedef struct bench_mode {
+    const char *name;
+    uint32_t    flags;
+    int         lazy;
+    int         probe;
+} bench_mode_t;
+
+typedef struct bench_rec64 {
+    uint64_t seq;
+    uint8_t  payload[56];
+} bench_rec64_t;
+
+typedef struct bench_rec256 {
+    uint64_t seq;
+    uint8_t  payload[248];
+} bench_rec256_t;
+
+SPSC_RING_DEFINE(bench_ring64, bench_rec64_t)
+SPSC_RING_DEFINE(bench_ring256, bench_rec256_t)
+
+typedef struct bench_side {
+    void        *ring;
+    uint64_t     items;
+    int          cpu;
+    atomic_int  *go;
+    uint64_t     mismatches;
+} bench_side_t;
+
+static const uint32_t bench_distances[] = { 0, 4, 16, 64, 256 };
+
+static const bench_mode_t bench_modes[] = {
+    { "index",          0,                  0, 0 },
+    { "index-lazy",     0,                  1, 0 },
+    { "sentinel",       SPSC_RING_SENTINEL, 0, 0 },
+    { "sentinel-probe", SPSC_RING_SENTINEL, 0, 1 },
+};
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void bench_pin(int cpu)
+{
+#ifdef __linux__
+    if (cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+static void bench_backoff(uint32_t *fails)
+{
+    if (++*fails >= BENCH_SPIN_BEFORE_YIELD)
+    {
+        *fails = 0;
+        sched_yield();
+    }
+}
+
+static void *bench_producer(void *arg)
+{
+    bench_side_t *side = arg;
+    bench_pin(side->cpu);
+    while (!atomic_load(side->go)) { }
+
+    uint32_t fails = 0;
+    for (uint64_t i = 0; i < side->items; ++i)
+    {
+        while (spsc_ring_push_inline(side->ring, (int)(i & 0x7fffffff)) != 0)
+        {
+            bench_backoff(&fails);
+        }
+    }
+    spsc_ring_flush(side->ring);
+    return NULL;
+}
+
+static void *bench_consumer(void *arg)
+{
+    bench_side_t *side = arg;
+    bench_pin(side->cpu);
+    while (!atomic_load(side->go)) { }
+
+    uint32_t fails = 0;
+    for (uint64_t i = 0; i < side->items; ++i)
+    {
+        int value;
+        while (spsc_ring_pop_inline(side->ring, &value) != 0)
+        {
+            bench_backoff(&fails);
+        }
+        side->mismatches += (value != (int)(i & 0x7fffffff));
+    }
+    return NULL;
+}
+
+/*
+ * Producer and consumer threads for a typed ring; the records carry their
+ * sequence number in seq and the consumer reads the whole record out.
+ */
+#define BENCH_TYPED(name, T)                                                           \
+    static void *name##_producer(void *arg)                                            \
+    {                                                                                  \
+        bench_side_t *side = arg;                                                      \
+        bench_pin(side->cpu);                                                          \
+        while (!atomic_load(side->go)) { }                                             \
+                                                                                       \
+        T        rec   = { 0 };                                                        \
+        uint32_t fails = 0;                                                            \
+        for (uint64_t i = 0; i < side->items; ++i)                                     \
+        {                                                                              \
+            rec.seq = i;                                                               \
+            while (name##_push(side->ring, rec) != 0)                                  \
+            {                                                                          \
+                bench_backoff(&fails);                                                 \
+            }                                                                          \
+        }                                                                              \
+        return NULL;                                                                   \
+    }                                                                                  \
+                                                                                       \
+    static void *name##_consumer(void *arg)                                            \
+    {                                                                                  \
+        bench_side_t *side = arg;                                                      \
+        bench_pin(side->cpu);                                                          \
+        while (!atomic_load(side->go)) { }                                             \
+                                                                                       \
+        uint32_t fails = 0;                                                            \
+        for (uint64_t i = 0; i < side->items; ++i)                                     \
+        {                                                                              \
+            T rec;                                                                     \
+            while (name##_pop(side->ring, &rec) != 0)                                  \
+            {                                                                          \
+                bench_backoff(&fails);                                                 \
+            }                                                                          \
+            side->mismatches += (rec.seq != i);                                        \
+        }                                                                              \
+        return NULL;                                                                   \
+    }
+
+BENCH_TYPED(bench_ring64, bench_rec64_t)
+BENCH_TYPED(bench_ring256, bench_rec256_t)
+
+/*
+ * Runs one transfer between the two thread functions, which share ring;
+ * returns the elapsed ns, 0 if a thread could not start or the consumer
+ * saw an element out of order.
+ */
+static uint64_t bench_time(void *ring, void *(*producer)(void *), void *(*consumer)(void *),
+                           uint64_t items, int producer_cpu, int consumer_cpu)
+{
+    atomic_int   go   = 0;
+    bench_side_t prod = { ring, items, producer_cpu, &go, 0 };
+    bench_side_t cons = { ring, items, consumer_cpu, &go, 0 };
+    pthread_t    pt, ct;
+    if (pthread_create(&ct, NULL, consumer, &cons) != 0)
+    {
+        return 0;
+    }
+    if (pthread_create(&pt, NULL, producer, &prod) != 0)
+    {
+        cons.items = 0;
+        atomic_store(&go, 1);
+        pthread_join(ct, NULL);
+        return 0;
+    }
+
+    uint64_t start = bench_now_ns();
+    atomic_store(&go, 1);
+    pthread_join(pt, NULL);
+    pthread_join(ct, NULL);
+    uint64_t elapsed = bench_now_ns() - start;
+
+    if (cons.mismatches != 0)
+    {
+        fprintf(stderr, "%llu elements out of order\n", (unsigned long long)cons.mismatches);
+        return 0;
+    }
+    return elapsed ? elapsed : 1;
+}
+
+/* One transfer through an int ring in the given mode */
+static uint64_t bench_run(const bench_mode_t *mode, uint32_t distance, uint64_t items,
+                          uint32_t capacity, int producer_cpu, int consumer_cpu)
+{
+    spsc_ring_t *ring = spsc_ring_init_ex(capacity, mode->flags);
+    if (ring == NULL)
+    {
+        return 0;
+    }
+    if (mode->lazy)
+    {
+        spsc_ring_set_lazy(ring, capacity / 8, 0);
+    }
+    if (mode->probe)
+    {
+        spsc_ring_set_probe(ring, (capacity / 8 > 1) ? capacity / 8 : 1);
+    }
+    spsc_ring_set_prefetch(ring, distance);
+
+    uint64_t ns = bench_time(ring, bench_producer, bench_consumer, items,
+                             producer_cpu, consumer_cpu);
+    spsc_ring_destroy(&ring);
+    return ns;
+}
+
+/* One transfer through a typed ring of elem_size byte records */
+static uint64_t bench_run_typed(size_t elem_size, uint32_t distance, uint64_t items,
+                                uint32_t capacity, int producer_cpu, int consumer_cpu)
+{
+    uint64_t ns = 0;
+    if (elem_size == sizeof(bench_rec64_t))
+    {
+        bench_ring64_t *ring = bench_ring64_init(capacity);
+        if (ring == NULL) return 0;
+        bench_ring64_set_prefetch(ring, distance);
+        ns = bench_time(ring, bench_ring64_producer, bench_ring64_consumer, items,
+                        producer_cpu, consumer_cpu);
+        bench_ring64_destroy(&ring);
+    }
+    else
+    {
+        bench_ring256_t *ring = bench_ring256_init(capacity);
+        if (ring == NULL) return 0;
+        bench_ring256_set_prefetch(ring, distance);
+        ns = bench_time(ring, bench_ring256_producer, bench_ring256_consumer, items,
+                        producer_cpu, consumer_cpu);
+        bench_ring256_destroy(&ring);
+    }
+    return ns;
+}
+
+/* Best of runs; elem_size 0 selects the int ring in mode */
+static uint64_t bench_best(const bench_mode_t *mode, size_t elem_size, uint32_t distance,
+                           uint64_t items, uint32_t capacity, int producer_cpu,
+                           int consumer_cpu, int runs)
+{
+    uint64_t best = 0;
+    for (int r = 0; r < runs; ++r)
+    {
+        uint64_t ns = (elem_size == 0)
+                    ? bench_run(mode, distance, items, capacity, producer_cpu, consumer_cpu)
+                    : bench_run_typed(elem_size, distance, items, capacity, producer_cpu,
+                                      consumer_cpu);
+        if (ns == 0)
+        {
+            return 0;
+        }
+        if (best == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+/*
+ * Copies chunk-byte chunks from a small source into a BENCH_COPY_SPAN
+ * destination until BENCH_COPY_TOTAL bytes are written; returns GB/s of
+ * the best of runs, 0 if the buffers cannot be allocated.
+ */
+#define BENCH_COPY_SPAN  (64u << 20)
+#define BENCH_COPY_TOTAL (256ull << 20)
+
+static double bench_copy(spsc_ring_copy_fn copy, size_t chunk, int runs)
+{
+    uint8_t *src = malloc(chunk);
+    uint8_t *dst = malloc(BENCH_COPY_SPAN);
+    if (src == NULL || dst == NULL)
+    {
+        free(src);
+        free(dst);
+        return 0;
+    }
+    memset(src, 0x5a, chunk);
+    memset(dst, 0, BENCH_COPY_SPAN);
+
+    uint64_t best = 0;
+    for (int r = 0; r < runs; ++r)
+    {
+        size_t   off   = 0;
+        uint64_t start = bench_now_ns();
+        for (uint64_t done = 0; done < BENCH_COPY_TOTAL; done += chunk)
+        {
+            copy(dst + off, src, chunk);
+            off = (off + chunk + chunk > BENCH_COPY_SPAN) ? 0 : off + chunk;
+        }
+        uint64_t ns = bench_now_ns() - start;
+        if (best == 0 || ns < best) best = ns ? ns : 1;
+    }
+    free(src);
+    free(dst);
+    return (double)BENCH_COPY_TOTAL / (double)best;
+}
+
+static void bench_report(const char *name, uint64_t best, uint64_t items)
+{
+    if (best == 0)
+    {
+        printf("%-16s %12s %10s\n", name, "failed", "-");
+        return;
+    }
+    printf("%-16s %12.2f %10.2f\n", name,
+           (double)items * 1e3 / (double)best, (double)best / (double)items);
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t items        = (argc > 1) ? strtoull(argv[1], NULL, 0) : 10000000ull;
+    uint32_t capacity     = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 1024u;
+    int      producer_cpu = (argc > 4) ? (int)strtol(argv[3], NULL, 0) : -1;
+    int      consumer_cpu = (argc > 4) ? (int)strtol(argv[4], NULL, 0) : -1;
+    int      runs         = (argc > 5) ? (int)strtol(argv[5], NULL, 0) : 3;
+
+    if (items == 0 || capacity < 2 || (capacity & (capacity - 1)) != 0 || runs < 1)
+    {
+        fprintf(stderr, "usage: %s [items] [capacity (power of 2)] "
+                        "[producer_cpu consumer_cpu] [runs]\n", argv[0]);
+        return 2;
+    }
+
+    printf("%llu items, capacity %u, cpus %d/%d, best of %d\n",
+           (unsigned long long)items, capacity, producer_cpu, consumer_cpu, runs);
+    printf("%-16s %12s %10s\n", "mode", "Mops/s", "ns/op");
+
+    int status = 0;
+    for (size_t m = 0; m < sizeof(bench_modes) / sizeof(bench_modes[0]); ++m)
+    {
+        uint64_t best = bench_best(&bench_modes[m], 0, 0, items, capacity,
+                                   producer_cpu, consumer_cpu, runs);
+        bench_report(bench_modes[m].name, best, items);
+        status |= (best == 0);
+    }
+
+    static const size_t elem_sizes[] = { 0, sizeof(bench_rec64_t), sizeof(bench_rec256_t) };
+    printf("\nprefetch distance (index mode)\n");
+    printf("%-16s %12s %10s\n", "element/dist", "Mops/s", "ns/op");
+    for (size_t e = 0; e < sizeof(elem_sizes) / sizeof(elem_sizes[0]); ++e)
+    {
+        for (size_t d = 0; d < sizeof(bench_distances) / sizeof(bench_distances[0]); ++d)
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "%zuB/%u", elem_sizes[e] ? elem_sizes[e] : sizeof(int),
+                     bench_distances[d]);
+            uint64_t best = bench_best(&bench_modes[0], elem_sizes[e], bench_distances[d],
+                                       items, capacity, producer_cpu, consumer_cpu, runs);
+            bench_report(name, best, items);
+            status |= (best == 0);
+        }
+    }
+
+    static const char  *kernels[] = { "avx512", "avx2", "sse2", "scalar" };
+    static const size_t chunks[]  = { 64, 256, 4096, 1u << 20 };
+    printf("\ncopy kernels, GB/s (default: %s)\n", spsc_ring_copy_kernel());
+    printf("%-16s %12s %10s\n", "kernel/chunk", "memcpy", "stream");
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k)
+    {
+        if (spsc_ring_copy_select(kernels[k]) != 0)
+        {
+            continue;   /* Not on this CPU */
+        }
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); ++c)
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "%s/%zu", kernels[k], chunks[c]);
+            printf("%-16s %12.2f %10.2f\n", name, bench_copy(spsc_ring_copy, chunks[c], runs),
+                   bench_copy(spsc_ring_copy_stream, chunks[c], runs));
+        }
+    }
+    spsc_ring_copy_select(NULL);
+    return status;
+}
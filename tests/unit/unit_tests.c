@@ -2,9 +2,39 @@
 #include <stddef.h>
 #include <setjmp.h>
 #include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <poll.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
 #include <cmocka.h>
 
 #include "spsc_ring.h"
+#include "spsc_ring_inline.h"
+#include "spsc_ring_typed.h"
+#include "spsc_msg_ring.h"
+#include "spsc_ring_dir.h"
+#include "spsc_ring_internal.h"  /* shared-memory header, to fake a half-done claim */
+
+typedef struct test_record {
+    uint64_t seq;
+    uint32_t payload[14];
+} test_record_t;
+
+typedef struct test_wide_record {
+    _Alignas(256) uint64_t seq;
+} test_wide_record_t;
+
+SPSC_RING_DEFINE(record_ring, test_record_t)
+SPSC_RING_DEFINE(ptr_ring, void *)
+SPSC_RING_DEFINE(wide_ring, test_wide_record_t)
 
 static spsc_ring_t *create_ring(uint32_t capacity)
 {
@@ -64,8 +94,30 @@ static void test_detects_full_ring(void **state)
     assert_int_equal(0, spsc_ring_push(ring, 11));
     assert_int_equal(0, spsc_ring_push(ring, 22));
     assert_int_equal(0, spsc_ring_push(ring, 33));
+    assert_false(spsc_ring_is_full(ring));
+    assert_int_equal(0, spsc_ring_push(ring, 44));
     assert_true(spsc_ring_is_full(ring));
-    assert_int_equal(-1, spsc_ring_push(ring, 44));
+    assert_int_equal(-1, spsc_ring_push(ring, 55));
+
+    destroy_ring(&ring);
+}
+
+static void test_every_slot_is_usable(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = create_ring(1);
+
+    for(int round = 0; round < 3; ++round)
+    {
+        assert_int_equal(0, spsc_ring_push(ring, round));
+        assert_true(spsc_ring_is_full(ring));
+        assert_int_equal(-1, spsc_ring_push(ring, round));
+
+        int value = -1;
+        assert_int_equal(0, spsc_ring_pop(ring, &value));
+        assert_int_equal(round, value);
+        assert_true(spsc_ring_is_empty(ring));
+    }
 
     destroy_ring(&ring);
 }
@@ -87,7 +139,7 @@ static void test_push_returns_error_when_ring_full(void **state)
     (void)state;
     spsc_ring_t *ring = create_ring(8);
 
-    for(int i = 0; i < 7; ++i)
+    for(int i = 0; i < 8; ++i)
     {
         assert_int_equal(0, spsc_ring_push(ring, i));
     }
@@ -110,6 +162,2292 @@ static void test_pop_succeeds_when_not_empty(void **state)
     destroy_ring(&ring);
 }
 
+static void test_producer_sees_space_freed_by_consumer(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = create_ring(4);
+
+    for(int i = 0; i < 4; ++i)
+    {
+        assert_int_equal(0, spsc_ring_push(ring, i));
+    }
+    assert_int_equal(-1, spsc_ring_push(ring, 99));
+
+    /* The producer's cached head is stale here and must be refreshed. */
+    int value = -1;
+    assert_int_equal(0, spsc_ring_pop(ring, &value));
+    assert_int_equal(0, value);
+    assert_false(spsc_ring_is_full(ring));
+    assert_int_equal(0, spsc_ring_push(ring, 4));
+
+    for(int expected = 1; expected <= 4; ++expected)
+    {
+        assert_int_equal(0, spsc_ring_pop(ring, &value));
+        assert_int_equal(expected, value);
+    }
+    assert_true(spsc_ring_is_empty(ring));
+
+    destroy_ring(&ring);
+}
+
+static void test_bulk_push_pop_wraps_around(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = create_ring(8);
+
+    /* Move head/tail close to the end of buf so the batch has to wrap. */
+    int scratch[8];
+    int src[6] = {10, 11, 12, 13, 14, 15};
+    assert_int_equal(5, spsc_ring_push_bulk(ring, src, 5));
+    assert_int_equal(5, spsc_ring_pop_bulk(ring, scratch, 8));
+
+    assert_int_equal(6, spsc_ring_push_bulk(ring, src, 6));
+    int dst[6] = {0};
+    assert_int_equal(6, spsc_ring_pop_bulk(ring, dst, 6));
+    assert_memory_equal(src, dst, sizeof(src));
+    assert_true(spsc_ring_is_empty(ring));
+
+    destroy_ring(&ring);
+}
+
+static void test_bulk_best_effort_and_all_or_nothing(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = create_ring(8);
+
+    int src[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    assert_int_equal(-1, spsc_ring_push_bulk_all(ring, src, 9));
+    assert_true(spsc_ring_is_empty(ring));
+    assert_int_equal(8, spsc_ring_push_bulk(ring, src, 10));
+    assert_true(spsc_ring_is_full(ring));
+    assert_int_equal(0, spsc_ring_push_bulk(ring, src, 1));
+
+    int dst[10] = {0};
+    assert_int_equal(-1, spsc_ring_pop_bulk_all(ring, dst, 9));
+    assert_int_equal(0, spsc_ring_pop_bulk_all(ring, dst, 4));
+    assert_int_equal(4, spsc_ring_pop_bulk(ring, dst + 4, 10));
+    assert_memory_equal(src, dst, 8 * sizeof(int));
+    assert_int_equal(0, spsc_ring_pop_bulk(ring, dst, 1));
+
+    assert_int_equal(0, spsc_ring_push_bulk(NULL, src, 1));
+    assert_int_equal(-1, spsc_ring_pop_bulk_all(NULL, dst, 1));
+
+    destroy_ring(&ring);
+}
+
+static void test_reserve_commit_spans_wrap(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = create_ring(8);
+
+    int scratch[8];
+    int src[6] = {0};
+    assert_int_equal(6, spsc_ring_push_bulk(ring, src, 6));
+    assert_int_equal(6, spsc_ring_pop_bulk(ring, scratch, 6));
+
+    spsc_ring_span_t first;
+    spsc_ring_span_t second;
+    assert_int_equal(5, spsc_ring_reserve(ring, 5, &first, &second));
+    assert_int_equal(2, first.len);
+    assert_int_equal(3, second.len);
+
+    int value = 100;
+    for(uint32_t i = 0; i < first.len; ++i) first.data[i] = value++;
+    for(uint32_t i = 0; i < second.len; ++i) second.data[i] = value++;
+
+    /* Nothing is visible before commit. */
+    assert_true(spsc_ring_is_empty(ring));
+    assert_int_equal(-1, spsc_ring_commit(ring, 6));
+    assert_int_equal(0, spsc_ring_commit(ring, 4));
+
+    int dst[8] = {0};
+    assert_int_equal(4, spsc_ring_pop_bulk(ring, dst, 8));
+    for(int i = 0; i < 4; ++i)
+    {
+        assert_int_equal(100 + i, dst[i]);
+    }
+
+    /* Without a second span the reservation stops at the end of buf. */
+    assert_int_equal(8, spsc_ring_reserve(ring, 9, &first, &second));
+    assert_int_equal(2, second.len);
+    assert_int_equal(0, spsc_ring_commit(ring, 0));
+    assert_int_equal(6, spsc_ring_reserve(ring, 8, &first, NULL));
+    assert_int_equal(6, first.len);
+
+    destroy_ring(&ring);
+}
+
+static void test_peek_release_in_place(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = create_ring(8);
+
+    spsc_ring_cspan_t first;
+    spsc_ring_cspan_t second;
+    assert_int_equal(0, spsc_ring_peek(ring, 8, &first, &second));
+    assert_int_equal(-1, spsc_ring_release(ring, 1));
+
+    int src[7] = {1, 2, 3, 4, 5, 6, 7};
+    assert_int_equal(5, spsc_ring_push_bulk(ring, src, 5));
+    assert_int_equal(0, spsc_ring_release(ring, 5));
+    assert_int_equal(6, spsc_ring_push_bulk(ring, src, 6));
+
+    /* Readable run starts at slot 5 and wraps after three elements. */
+    assert_int_equal(6, spsc_ring_peek(ring, 8, &first, &second));
+    assert_int_equal(3, first.len);
+    assert_int_equal(3, second.len);
+    assert_memory_equal(src, first.data, 3 * sizeof(int));
+    assert_memory_equal(src + 3, second.data, 3 * sizeof(int));
+
+    /* Peeking does not consume; release hands slots back in one step. */
+    assert_int_equal(3, spsc_ring_peek(ring, 8, &first, NULL));
+    assert_int_equal(0, spsc_ring_release(ring, 4));
+    int value = 0;
+    assert_int_equal(0, spsc_ring_pop(ring, &value));
+    assert_int_equal(5, value);
+    assert_int_equal(-1, spsc_ring_release(ring, 2));
+    assert_int_equal(0, spsc_ring_release(ring, 1));
+    assert_true(spsc_ring_is_empty(ring));
+
+    destroy_ring(&ring);
+}
+
+static void test_inline_hot_path_mixes_with_library_calls(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = create_ring(4);
+
+    assert_int_equal(0, spsc_ring_push_inline(ring, 1));
+    assert_int_equal(0, spsc_ring_push(ring, 2));
+    assert_int_equal(0, spsc_ring_push_inline(ring, 3));
+    assert_int_equal(0, spsc_ring_push(ring, 4));
+    assert_true(spsc_ring_is_full_inline(ring));
+    assert_int_equal(-1, spsc_ring_push_inline(ring, 5));
+
+    for(int expected = 1; expected <= 4; ++expected)
+    {
+        int value = -1;
+        int rc = (expected % 2) ? spsc_ring_pop(ring, &value) : spsc_ring_pop_inline(ring, &value);
+        assert_int_equal(0, rc);
+        assert_int_equal(expected, value);
+    }
+    assert_true(spsc_ring_is_empty_inline(ring));
+    assert_int_equal(-1, spsc_ring_pop_inline(ring, NULL));
+
+    destroy_ring(&ring);
+}
+
+static void test_typed_ring_large_records(void **state)
+{
+    (void)state;
+    assert_null(record_ring_init(6));
+    record_ring_t *ring = record_ring_init(4);
+    assert_non_null(ring);
+    assert_true(record_ring_is_empty(ring));
+
+    test_record_t batch[5];
+    for(uint32_t i = 0; i < 5; ++i)
+    {
+        memset(&batch[i], 0, sizeof(batch[i]));
+        batch[i].seq = i;
+        batch[i].payload[13] = 0xA0u + i;
+    }
+    assert_int_equal(-1, record_ring_push_bulk_all(ring, batch, 5));
+    assert_int_equal(0, record_ring_push_bulk_all(ring, batch, 2));
+    assert_int_equal(0, record_ring_push(ring, batch[2]));
+    assert_false(record_ring_is_full(ring));
+
+    test_record_t out;
+    assert_int_equal(0, record_ring_pop(ring, &out));
+    assert_memory_equal(&batch[0], &out, sizeof(out));
+    assert_int_equal(0, record_ring_pop(ring, &out));
+
+    /* Both bulk copies wrap around the end of the slot array. */
+    assert_int_equal(3, record_ring_push_bulk(ring, batch, 5));
+    assert_true(record_ring_is_full(ring));
+    assert_int_equal(-1, record_ring_push(ring, batch[4]));
+    test_record_t drained[5];
+    assert_int_equal(4, record_ring_pop_bulk(ring, drained, 5));
+    assert_int_equal(2, drained[0].seq);
+    assert_int_equal(0, drained[1].seq);
+    assert_int_equal(1, drained[2].seq);
+    assert_int_equal(2, drained[3].seq);
+    assert_int_equal(0xA1u, drained[2].payload[13]);
+    assert_int_equal(-1, record_ring_pop_bulk_all(ring, drained, 1));
+
+    record_ring_destroy(&ring);
+    assert_null(ring);
+}
+
+static void test_typed_ring_over_aligned_slots(void **state)
+{
+    (void)state;
+    wide_ring_t *ring = wide_ring_init(4);
+    assert_non_null(ring);
+
+    /* Slots honour _Alignof(T) and sit right behind the structure. */
+    uintptr_t base = (uintptr_t)ring;
+    uintptr_t buf  = (uintptr_t)ring->cfg.buf;
+    assert_int_equal(0, buf % _Alignof(test_wide_record_t));
+    assert_true(buf >= base + sizeof(*ring));
+    assert_true(buf < base + sizeof(*ring) + _Alignof(test_wide_record_t));
+
+    test_wide_record_t in[6];
+    test_wide_record_t out[6];
+    memset(in, 0, sizeof(in));
+    for(uint32_t i = 0; i < 6; ++i) in[i].seq = i;
+    assert_int_equal(0, wide_ring_push_bulk_all(ring, in, 3));
+    assert_int_equal(0, wide_ring_pop_bulk_all(ring, out, 3));
+    assert_int_equal(0, wide_ring_push_bulk_all(ring, in + 3, 3));   /* wraps */
+    assert_int_equal(0, wide_ring_pop_bulk_all(ring, out + 3, 3));
+    for(uint32_t i = 0; i < 6; ++i) assert_int_equal(i, out[i].seq);
+
+    wide_ring_destroy(&ring);
+    assert_null(ring);
+}
+
+static void test_typed_ring_pointers(void **state)
+{
+    (void)state;
+    ptr_ring_t *ring = ptr_ring_init(2);
+    assert_non_null(ring);
+
+    int a = 1;
+    int b = 2;
+    assert_int_equal(0, ptr_ring_push(ring, &a));
+    assert_int_equal(0, ptr_ring_push(ring, &b));
+    assert_int_equal(-1, ptr_ring_push(ring, &a));
+
+    void *out = NULL;
+    assert_int_equal(0, ptr_ring_pop(ring, &out));
+    assert_ptr_equal(&a, out);
+    assert_int_equal(0, ptr_ring_pop(ring, &out));
+    assert_ptr_equal(&b, out);
+    assert_int_equal(-1, ptr_ring_pop(ring, &out));
+
+    ptr_ring_destroy(&ring);
+}
+
+static void test_msg_ring_variable_length_records(void **state)
+{
+    (void)state;
+    assert_null(spsc_msg_ring_init(8));
+    assert_null(spsc_msg_ring_init(100));
+    spsc_msg_ring_t *ring = spsc_msg_ring_init(64);
+    assert_non_null(ring);
+    assert_int_equal(24, spsc_msg_ring_max_msg(ring));
+    assert_int_equal(-1, spsc_msg_ring_push(ring, "x", 25));
+
+    uint32_t len = 0;
+    assert_null(spsc_msg_ring_peek(ring, &len));
+    assert_int_equal(-1, spsc_msg_ring_release(ring));
+
+    /* 16 + 16 + 8 bytes of records, leaving 24 bytes before the end. */
+    assert_int_equal(0, spsc_msg_ring_push(ring, "hello", 5));
+    assert_int_equal(0, spsc_msg_ring_push(ring, "world!!!", 8));
+    assert_int_equal(0, spsc_msg_ring_push(ring, NULL, 0));
+    assert_int_equal(-1, spsc_msg_ring_push(ring, "0123456789abcdefg", 17));
+
+    const char *view = spsc_msg_ring_peek(ring, &len);
+    assert_non_null(view);
+    assert_int_equal(0, ((uintptr_t)view) % 8);
+    assert_int_equal(5, len);
+    assert_memory_equal("hello", view, 5);
+    assert_int_equal(0, spsc_msg_ring_release(ring));
+    view = spsc_msg_ring_peek(ring, &len);
+    assert_int_equal(8, len);
+    assert_memory_equal("world!!!", view, 8);
+    assert_int_equal(0, spsc_msg_ring_release(ring));
+
+    /* Needs 32 contiguous bytes: skip record at offset 40, message at 0. */
+    assert_int_equal(0, spsc_msg_ring_push(ring, "0123456789abcdefg", 17));
+
+    view = spsc_msg_ring_peek(ring, &len);
+    assert_non_null(view);
+    assert_int_equal(0, len);
+    assert_int_equal(0, spsc_msg_ring_release(ring));
+    view = spsc_msg_ring_peek(ring, &len);
+    assert_int_equal(17, len);
+    assert_memory_equal("0123456789abcdefg", view, 17);
+    assert_int_equal(0, spsc_msg_ring_release(ring));
+    assert_true(spsc_msg_ring_is_empty(ring));
+
+    spsc_msg_ring_destroy(&ring);
+    assert_null(ring);
+}
+
+static void test_msg_ring_reserve_commit_shorter(void **state)
+{
+    (void)state;
+    spsc_msg_ring_t *ring = spsc_msg_ring_init(128);
+    assert_non_null(ring);
+
+    assert_int_equal(-1, spsc_msg_ring_commit(ring, 0));
+    char *dst = spsc_msg_ring_reserve(ring, 32);
+    assert_non_null(dst);
+    memcpy(dst, "abc", 3);
+    assert_true(spsc_msg_ring_is_empty(ring));
+    assert_int_equal(-1, spsc_msg_ring_commit(ring, 33));
+    assert_int_equal(0, spsc_msg_ring_commit(ring, 3));
+    assert_int_equal(-1, spsc_msg_ring_commit(ring, 3));
+
+    uint32_t len = 0;
+    const char *view = spsc_msg_ring_peek(ring, &len);
+    assert_int_equal(3, len);
+    assert_memory_equal("abc", view, 3);
+
+    spsc_msg_ring_destroy(&ring);
+}
+
+#define THREADED_ITEMS 200000
+
+static void *threaded_producer(void *arg)
+{
+    spsc_ring_t *ring = arg;
+    for(int i = 0; i < THREADED_ITEMS; ++i)
+    {
+        while(spsc_ring_push(ring, i) != 0)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void test_threaded_fifo_order(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = create_ring(64);
+
+    pthread_t producer;
+    assert_int_equal(0, pthread_create(&producer, NULL, threaded_producer, ring));
+
+    int mismatches = 0;
+    for(int expected = 0; expected < THREADED_ITEMS; ++expected)
+    {
+        int value = -1;
+        while(spsc_ring_pop(ring, &value) != 0)
+        {
+            sched_yield();
+        }
+        mismatches += (value != expected);
+    }
+    assert_int_equal(0, pthread_join(producer, NULL));
+    assert_int_equal(0, mismatches);
+    assert_true(spsc_ring_is_empty(ring));
+
+    destroy_ring(&ring);
+}
+
+static void test_init_ex_rejects_unknown_flags(void **state)
+{
+    (void)state;
+    assert_null(spsc_ring_init_ex(8, 1u << 31));
+    assert_null(spsc_ring_init_ex(6, SPSC_RING_BLOCKING));
+
+    spsc_ring_t *ring = spsc_ring_init_ex(8, SPSC_RING_BLOCKING);
+    assert_non_null(ring);
+    destroy_ring(&ring);
+}
+
+static void test_wait_requires_blocking_ring(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = create_ring(8);
+
+    int value = 0;
+    errno = 0;
+    assert_int_equal(-1, spsc_ring_pop_wait(ring, &value, 1000));
+    assert_int_equal(EINVAL, errno);
+    assert_int_equal(-1, spsc_ring_push_wait(NULL, 1, -1));
+    assert_int_equal(EINVAL, errno);
+
+    destroy_ring(&ring);
+}
+
+static void test_wait_times_out(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = spsc_ring_init_ex(2, SPSC_RING_BLOCKING);
+    assert_non_null(ring);
+
+    struct timespec start;
+    struct timespec end;
+    int value = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    errno = 0;
+    assert_int_equal(-1, spsc_ring_pop_wait(ring, &value, 20 * 1000 * 1000));
+    assert_int_equal(ETIMEDOUT, errno);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    int64_t elapsed_ns = (int64_t)(end.tv_sec - start.tv_sec) * 1000000000 + (end.tv_nsec - start.tv_nsec);
+    assert_true(elapsed_ns >= 20 * 1000 * 1000);
+
+    assert_int_equal(-1, spsc_ring_pop_wait(ring, &value, 0));
+    assert_int_equal(ETIMEDOUT, errno);
+
+    /* A deadline that already passed still lets a ready operation through. */
+    assert_int_equal(0, spsc_ring_push_wait_until(ring, 7, &start));
+    assert_int_equal(0, spsc_ring_push_wait(ring, 8, 0));
+    assert_int_equal(-1, spsc_ring_push_wait_until(ring, 9, &start));
+    assert_int_equal(ETIMEDOUT, errno);
+    assert_int_equal(0, spsc_ring_pop_wait_until(ring, &value, &start));
+    assert_int_equal(7, value);
+
+    spsc_ring_destroy(&ring);
+}
+
+static void *blocking_producer(void *arg)
+{
+    spsc_ring_t *ring = arg;
+    for(int i = 0; i < THREADED_ITEMS; ++i)
+    {
+        if(spsc_ring_push_wait(ring, i, -1) != 0)
+        {
+            return arg;
+        }
+    }
+    return NULL;
+}
+
+static void test_threaded_blocking_handoff(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = spsc_ring_init_ex(4, SPSC_RING_BLOCKING);
+    assert_non_null(ring);
+    /* Park straight away so both sides really go through the futex. */
+    assert_int_equal(0, spsc_ring_set_spin(ring, 0));
+
+    pthread_t producer;
+    assert_int_equal(0, pthread_create(&producer, NULL, blocking_producer, ring));
+
+    int mismatches = 0;
+    for(int expected = 0; expected < THREADED_ITEMS; ++expected)
+    {
+        int value = -1;
+        assert_int_equal(0, spsc_ring_pop_wait(ring, &value, -1));
+        mismatches += (value != expected);
+    }
+    void *result = ring;
+    assert_int_equal(0, pthread_join(producer, &result));
+    assert_null(result);
+    assert_int_equal(0, mismatches);
+
+    spsc_ring_destroy(&ring);
+}
+
+static int eventfd_readable(int efd)
+{
+    struct pollfd pfd = { .fd = efd, .events = POLLIN };
+    return poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+}
+
+static void test_eventfd_signals_empty_to_non_empty(void **state)
+{
+    (void)state;
+    spsc_ring_t *plain = spsc_ring_init(4);
+    assert_int_equal(-1, spsc_ring_get_eventfd(plain));
+    assert_int_equal(-1, spsc_ring_eventfd_drain(plain));
+    spsc_ring_destroy(&plain);
+
+    spsc_ring_t *ring = spsc_ring_init_ex(8, SPSC_RING_EVENTFD);
+    assert_non_null(ring);
+    int efd = spsc_ring_get_eventfd(ring);
+    assert_true(efd >= 0);
+    assert_false(eventfd_readable(efd));
+
+    /* First publish into the fresh (empty) ring signals, later ones don't. */
+    assert_int_equal(0, spsc_ring_push(ring, 1));
+    assert_int_equal(0, spsc_ring_push(ring, 2));
+    assert_int_equal(0, spsc_ring_push(ring, 3));
+    assert_true(eventfd_readable(efd));
+    uint64_t count = 0;
+    assert_int_equal((ssize_t)sizeof(count), read(efd, &count, sizeof(count)));
+    assert_int_equal(1, count);
+
+    /* Consumer still has data: no new signal until it drains the ring. */
+    int value = 0;
+    assert_int_equal(0, spsc_ring_pop(ring, &value));
+    assert_int_equal(0, spsc_ring_push(ring, 4));
+    assert_false(eventfd_readable(efd));
+
+    while (spsc_ring_pop(ring, &value) == 0) {}
+    assert_int_equal(4, value);
+    assert_false(eventfd_readable(efd));
+
+    /* The empty pop re-armed it. */
+    assert_int_equal(0, spsc_ring_push(ring, 5));
+    assert_true(eventfd_readable(efd));
+    assert_int_equal(0, spsc_ring_eventfd_drain(ring));
+    assert_false(eventfd_readable(efd));
+    assert_int_equal(0, spsc_ring_eventfd_drain(ring));
+
+    spsc_ring_destroy(&ring);
+}
+
+static void *eventfd_producer(void *arg)
+{
+    spsc_ring_t *ring = arg;
+    for(int i = 0; i < THREADED_ITEMS; ++i)
+    {
+        while(spsc_ring_push(ring, i) != 0)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void test_threaded_eventfd_poll_loop(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = spsc_ring_init_ex(64, SPSC_RING_EVENTFD);
+    assert_non_null(ring);
+    struct pollfd pfd = { .fd = spsc_ring_get_eventfd(ring), .events = POLLIN };
+
+    pthread_t producer;
+    assert_int_equal(0, pthread_create(&producer, NULL, eventfd_producer, ring));
+
+    /* Only ever sleep in poll(): a lost wake-up would hang the test. */
+    int expected   = 0;
+    int mismatches = 0;
+    while(expected < THREADED_ITEMS)
+    {
+        assert_int_equal(1, poll(&pfd, 1, 5000));
+        assert_int_equal(0, spsc_ring_eventfd_drain(ring));
+        int value;
+        while(spsc_ring_pop(ring, &value) == 0)
+        {
+            mismatches += (value != expected);
+            ++expected;
+        }
+    }
+    assert_int_equal(0, pthread_join(producer, NULL));
+    assert_int_equal(0, mismatches);
+
+    spsc_ring_destroy(&ring);
+}
+
+static void shm_test_name(char *name, size_t len, const char *tag)
+{
+    snprintf(name, len, "/spsc_ring_test_%s_%ld", tag, (long)getpid());
+}
+
+static void test_shm_create_attach_share_one_ring(void **state)
+{
+    (void)state;
+    char name[64];
+    shm_test_name(name, sizeof(name), "share");
+    spsc_ring_unlink_shm(name);
+
+    spsc_ring_t *creator = spsc_ring_create_shm(name, 8);
+    assert_non_null(creator);
+    assert_null(spsc_ring_create_shm(name, 8));
+    assert_int_equal(EEXIST, errno);
+
+    /* A second mapping sits at another address but sees the same ring. */
+    spsc_ring_t *attached = spsc_ring_attach_shm(name);
+    assert_non_null(attached);
+    assert_ptr_not_equal(creator, attached);
+    assert_int_equal(0, spsc_ring_unlink_shm(name));
+
+    for(int i = 0; i < 8; ++i)
+    {
+        assert_int_equal(0, spsc_ring_push(creator, i));
+    }
+    assert_true(spsc_ring_is_full(attached));
+    int out[8] = {0};
+    assert_int_equal(8, spsc_ring_pop_bulk(attached, out, 8));
+    for(int i = 0; i < 8; ++i)
+    {
+        assert_int_equal(i, out[i]);
+    }
+    assert_true(spsc_ring_is_empty(creator));
+
+    spsc_ring_destroy(&attached);
+    assert_null(attached);
+    spsc_ring_destroy(&creator);
+}
+
+static void test_shm_attach_rejects_missing_or_invalid(void **state)
+{
+    (void)state;
+    char name[64];
+    shm_test_name(name, sizeof(name), "bad");
+    spsc_ring_unlink_shm(name);
+
+    assert_null(spsc_ring_attach_shm(name));
+    assert_int_equal(ENOENT, errno);
+    assert_null(spsc_ring_create_shm(name, 6));
+    assert_int_equal(EINVAL, errno);
+    assert_null(spsc_ring_attach_shm(NULL));
+    assert_int_equal(-1, spsc_ring_unlink_shm(NULL));
+
+    /* A segment that was never initialised by spsc_ring_create_shm(). */
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    assert_true(fd >= 0);
+    assert_int_equal(0, ftruncate(fd, 4096));
+    close(fd);
+    assert_null(spsc_ring_attach_shm(name));
+    assert_int_equal(EAGAIN, errno);
+    assert_int_equal(0, spsc_ring_unlink_shm(name));
+}
+
+static void test_shm_attach_rejects_corrupt_cfg(void **state)
+{
+    (void)state;
+    char name[64];
+    shm_test_name(name, sizeof(name), "cfg");
+    spsc_ring_unlink_shm(name);
+
+    spsc_ring_t *ring = spsc_ring_create_shm(name, 8);
+    assert_non_null(ring);
+
+    /* Magic and layout hash are intact, only the ring's own cfg is off. */
+    ring->cfg.mask = 15;
+    assert_null(spsc_ring_attach_shm(name));
+    assert_int_equal(EINVAL, errno);
+    ring->cfg.mask = 7;
+
+    ring->cfg.buf_off += 64;
+    assert_null(spsc_ring_attach_shm(name));
+    assert_int_equal(EINVAL, errno);
+    ring->cfg.buf_off -= 64;
+
+    ring->cfg.flags |= SPSC_RING_MAGIC;
+    assert_null(spsc_ring_attach_shm(name));
+    assert_int_equal(EINVAL, errno);
+    ring->cfg.flags &= ~SPSC_RING_MAGIC;
+
+    spsc_ring_t *peer = spsc_ring_attach_shm(name);
+    assert_non_null(peer);
+    spsc_ring_destroy(&peer);
+    spsc_ring_destroy(&ring);
+    assert_int_equal(0, spsc_ring_unlink_shm(name));
+}
+
+static void test_shm_cross_process_fifo(void **state)
+{
+    (void)state;
+    char name[64];
+    shm_test_name(name, sizeof(name), "fork");
+    spsc_ring_unlink_shm(name);
+
+    spsc_ring_t *ring = spsc_ring_create_shm(name, 64);
+    assert_non_null(ring);
+
+    pid_t child = fork();
+    assert_true(child >= 0);
+    if(child == 0)
+    {
+        /* Producer process: attach by name like an unrelated process would. */
+        spsc_ring_t *prod = spsc_ring_attach_shm(name);
+        if(prod == NULL) _exit(1);
+        for(int i = 0; i < THREADED_ITEMS; ++i)
+        {
+            while(spsc_ring_push(prod, i) != 0)
+            {
+                sched_yield();
+            }
+        }
+        spsc_ring_destroy(&prod);
+        _exit(0);
+    }
+
+    int mismatches = 0;
+    for(int expected = 0; expected < THREADED_ITEMS; ++expected)
+    {
+        int value;
+        while(spsc_ring_pop(ring, &value) != 0)
+        {
+            sched_yield();
+        }
+        mismatches += (value != expected);
+    }
+    int status = -1;
+    assert_int_equal(child, waitpid(child, &status, 0));
+    assert_true(WIFEXITED(status));
+    assert_int_equal(0, WEXITSTATUS(status));
+    assert_int_equal(0, mismatches);
+
+    assert_int_equal(0, spsc_ring_unlink_shm(name));
+    spsc_ring_destroy(&ring);
+}
+
+static void test_shm_blocking_flags_and_timeout(void **state)
+{
+    (void)state;
+    char name[64];
+    shm_test_name(name, sizeof(name), "blkflags");
+    spsc_ring_unlink_shm(name);
+
+    assert_null(spsc_ring_create_shm_ex(name, 4, SPSC_RING_EVENTFD));
+    assert_int_equal(EINVAL, errno);
+
+    spsc_ring_t *ring = spsc_ring_create_shm_ex(name, 4, SPSC_RING_BLOCKING);
+    assert_non_null(ring);
+    spsc_ring_t *peer = spsc_ring_attach_shm(name);
+    assert_non_null(peer);
+    assert_int_equal(0, spsc_ring_unlink_shm(name));
+
+    int value = 0;
+    errno = 0;
+    assert_int_equal(-1, spsc_ring_pop_wait(peer, &value, 5 * 1000 * 1000));
+    assert_int_equal(ETIMEDOUT, errno);
+    assert_int_equal(0, spsc_ring_push_wait(ring, 11, -1));
+    assert_int_equal(0, spsc_ring_pop_wait(peer, &value, -1));
+    assert_int_equal(11, value);
+
+    spsc_ring_destroy(&peer);
+    spsc_ring_destroy(&ring);
+}
+
+static void test_shm_cross_process_blocking_handoff(void **state)
+{
+    (void)state;
+    char name[64];
+    shm_test_name(name, sizeof(name), "blk");
+    spsc_ring_unlink_shm(name);
+
+    spsc_ring_t *ring = spsc_ring_create_shm_ex(name, 4, SPSC_RING_BLOCKING);
+    assert_non_null(ring);
+    /* Park straight away so both processes really go through the futex. */
+    assert_int_equal(0, spsc_ring_set_spin(ring, 0));
+
+    pid_t child = fork();
+    assert_true(child >= 0);
+    if(child == 0)
+    {
+        spsc_ring_t *prod = spsc_ring_attach_shm(name);
+        if(prod == NULL) _exit(1);
+        for(int i = 0; i < THREADED_ITEMS; ++i)
+        {
+            if(spsc_ring_push_wait(prod, i, 5LL * 1000 * 1000 * 1000) != 0) _exit(2);
+        }
+        spsc_ring_destroy(&prod);
+        _exit(0);
+    }
+
+    /* A lost cross-process wake-up shows up as a timeout here. */
+    int mismatches = 0;
+    int timeouts   = 0;
+    for(int expected = 0; expected < THREADED_ITEMS && timeouts == 0; ++expected)
+    {
+        int value = -1;
+        timeouts  += (spsc_ring_pop_wait(ring, &value, 5LL * 1000 * 1000 * 1000) != 0);
+        mismatches += (value != expected);
+    }
+    int status = -1;
+    assert_int_equal(child, waitpid(child, &status, 0));
+    assert_true(WIFEXITED(status));
+    assert_int_equal(0, WEXITSTATUS(status));
+    assert_int_equal(0, timeouts);
+    assert_int_equal(0, mismatches);
+
+    assert_int_equal(0, spsc_ring_unlink_shm(name));
+    spsc_ring_destroy(&ring);
+}
+
+static void test_shm_claim_and_liveness(void **state)
+{
+    (void)state;
+    char name[64];
+    shm_test_name(name, sizeof(name), "claim");
+    spsc_ring_unlink_shm(name);
+
+    spsc_ring_t *heap = spsc_ring_init(4);
+    assert_int_equal(-1, spsc_ring_shm_claim(heap, SPSC_RING_SIDE_PRODUCER));
+    assert_int_equal(EINVAL, errno);
+    assert_int_equal(-1, spsc_ring_peer_alive(heap, SPSC_RING_SIDE_PRODUCER));
+    spsc_ring_destroy(&heap);
+
+    spsc_ring_t *ring = spsc_ring_create_shm(name, 4);
+    assert_non_null(ring);
+    assert_int_equal(-1, spsc_ring_shm_claim(ring, 2));
+    assert_int_equal(0, spsc_ring_peer_alive(ring, SPSC_RING_SIDE_CONSUMER));
+
+    assert_int_equal(0, spsc_ring_shm_claim(ring, SPSC_RING_SIDE_CONSUMER));
+    assert_int_equal(1, spsc_ring_peer_alive(ring, SPSC_RING_SIDE_CONSUMER));
+    assert_int_equal(-1, spsc_ring_shm_claim(ring, SPSC_RING_SIDE_CONSUMER));
+    assert_int_equal(EBUSY, errno);
+
+    uint64_t epoch = spsc_ring_peer_epoch(ring, SPSC_RING_SIDE_CONSUMER);
+    assert_int_equal(0, spsc_ring_shm_heartbeat(ring, SPSC_RING_SIDE_CONSUMER));
+    assert_int_equal(epoch + 1, spsc_ring_peer_epoch(ring, SPSC_RING_SIDE_CONSUMER));
+
+    /* Destroying the mapping gives the side up. */
+    spsc_ring_t *peer = spsc_ring_attach_shm(name);
+    assert_non_null(peer);
+    spsc_ring_destroy(&ring);
+    assert_int_equal(0, spsc_ring_peer_alive(peer, SPSC_RING_SIDE_CONSUMER));
+
+    assert_int_equal(0, spsc_ring_unlink_shm(name));
+    spsc_ring_destroy(&peer);
+}
+
+static void test_shm_claimant_dying_mid_claim_is_replaced(void **state)
+{
+    (void)state;
+    char name[64];
+    shm_test_name(name, sizeof(name), "midclaim");
+    spsc_ring_unlink_shm(name);
+
+    spsc_ring_t *ring = spsc_ring_create_shm(name, 4);
+    assert_non_null(ring);
+    spsc_shm_owner_t *owner = &spsc_shm_hdr(ring)->owner[SPSC_RING_SIDE_PRODUCER];
+
+    /* A claim in progress by a live process holds the side. */
+    atomic_store(&owner->pid, -(int32_t)getpid());
+    assert_int_equal(1, spsc_ring_peer_alive(ring, SPSC_RING_SIDE_PRODUCER));
+    assert_int_equal(-1, spsc_ring_shm_claim(ring, SPSC_RING_SIDE_PRODUCER));
+    assert_int_equal(EBUSY, errno);
+
+    /* One whose claimant died before finishing does not. */
+    pid_t child = fork();
+    assert_true(child >= 0);
+    if(child == 0) _exit(0);
+    assert_int_equal(child, waitpid(child, NULL, 0));
+    atomic_store(&owner->pid, -(int32_t)child);
+    assert_int_equal(0, spsc_ring_peer_alive(ring, SPSC_RING_SIDE_PRODUCER));
+    assert_int_equal(1, spsc_ring_shm_claim(ring, SPSC_RING_SIDE_PRODUCER));
+    assert_int_equal(getpid(), atomic_load(&owner->pid));
+    assert_int_equal(1, spsc_ring_peer_alive(ring, SPSC_RING_SIDE_PRODUCER));
+
+    assert_int_equal(0, spsc_ring_unlink_shm(name));
+    spsc_ring_destroy(&ring);
+}
+
+static void test_shm_producer_crash_and_recovery(void **state)
+{
+    (void)state;
+    char name[64];
+    shm_test_name(name, sizeof(name), "crash");
+    spsc_ring_unlink_shm(name);
+
+    spsc_ring_t *ring = spsc_ring_create_shm(name, 8);
+    assert_non_null(ring);
+    assert_int_equal(0, spsc_ring_shm_claim(ring, SPSC_RING_SIDE_CONSUMER));
+
+    pid_t child = fork();
+    assert_true(child >= 0);
+    if(child == 0)
+    {
+        spsc_ring_t *prod = spsc_ring_attach_shm(name);
+        if(prod == NULL || spsc_ring_shm_claim(prod, SPSC_RING_SIDE_PRODUCER) != 0) _exit(1);
+        for(int i = 0; i < 3; ++i)
+        {
+            spsc_ring_push(prod, i);
+        }
+        /* Die in the middle of an in-place write, without detaching. */
+        spsc_ring_span_t first;
+        spsc_ring_reserve(prod, 2, &first, NULL);
+        first.data[0] = 99;
+        abort();
+    }
+
+    int status = 0;
+    assert_int_equal(child, waitpid(child, &status, 0));
+    assert_true(WIFSIGNALED(status));
+    assert_int_equal(0, spsc_ring_peer_alive(ring, SPSC_RING_SIDE_PRODUCER));
+
+    /* Only the published elements are visible, never the reserved slot. */
+    int value = -1;
+    assert_int_equal(0, spsc_ring_pop(ring, &value));
+    assert_int_equal(0, value);
+
+    /* A restarted producer takes over and continues after element 2. */
+    spsc_ring_t *prod = spsc_ring_attach_shm(name);
+    assert_non_null(prod);
+    assert_int_equal(1, spsc_ring_shm_claim(prod, SPSC_RING_SIDE_PRODUCER));
+    assert_int_equal(1, spsc_ring_peer_alive(ring, SPSC_RING_SIDE_PRODUCER));
+    assert_int_equal(0, spsc_ring_commit(prod, 0));
+    assert_int_equal(0, spsc_ring_push(prod, 3));
+
+    for(int expected = 1; expected <= 3; ++expected)
+    {
+        assert_int_equal(0, spsc_ring_pop(ring, &value));
+        assert_int_equal(expected, value);
+    }
+    assert_true(spsc_ring_is_empty(ring));
+
+    assert_int_equal(0, spsc_ring_unlink_shm(name));
+    spsc_ring_destroy(&prod);
+    spsc_ring_destroy(&ring);
+}
+
+static void test_shm_claim_rejects_corrupt_indices(void **state)
+{
+    (void)state;
+    char name[64];
+    shm_test_name(name, sizeof(name), "corrupt");
+    spsc_ring_unlink_shm(name);
+
+    spsc_ring_t *ring = spsc_ring_create_shm(name, 4);
+    assert_non_null(ring);
+    atomic_store(&ring->prod.tail, atomic_load(&ring->cons.head) + 5);
+    assert_int_equal(-1, spsc_ring_shm_claim(ring, SPSC_RING_SIDE_PRODUCER));
+    assert_int_equal(EPROTO, errno);
+    assert_int_equal(0, spsc_ring_peer_alive(ring, SPSC_RING_SIDE_PRODUCER));
+
+    assert_int_equal(0, spsc_ring_unlink_shm(name));
+    spsc_ring_destroy(&ring);
+}
+
+static void file_test_path(char *path, size_t len, const char *tag)
+{
+    snprintf(path, len, "/tmp/spsc_ring_test_%s_%ld.ring", tag, (long)getpid());
+    unlink(path);
+}
+
+static void test_file_ring_survives_clean_reopen(void **state)
+{
+    (void)state;
+    char path[128];
+    file_test_path(path, sizeof(path), "reopen");
+
+    assert_null(spsc_ring_open_file(path, 6));
+    assert_int_equal(EINVAL, errno);
+    assert_null(spsc_ring_open_file(path, 0));
+
+    spsc_ring_t *ring = spsc_ring_open_file(path, 8);
+    assert_non_null(ring);
+    assert_true(spsc_ring_is_empty(ring));
+    /* One owner at a time. */
+    assert_null(spsc_ring_open_file(path, 8));
+    assert_int_equal(EBUSY, errno);
+
+    for(int i = 0; i < 5; ++i)
+    {
+        assert_int_equal(0, spsc_ring_push(ring, 100 + i));
+    }
+    int value = 0;
+    assert_int_equal(0, spsc_ring_pop(ring, &value));
+    assert_int_equal(100, value);
+    spsc_ring_destroy(&ring);
+
+    /* A clean close keeps everything; capacity must match or be 0. */
+    assert_null(spsc_ring_open_file(path, 16));
+    assert_int_equal(EINVAL, errno);
+    ring = spsc_ring_open_file(path, 0);
+    assert_non_null(ring);
+    for(int i = 1; i < 5; ++i)
+    {
+        assert_int_equal(0, spsc_ring_pop(ring, &value));
+        assert_int_equal(100 + i, value);
+    }
+    assert_true(spsc_ring_is_empty(ring));
+    spsc_ring_destroy(&ring);
+    unlink(path);
+}
+
+static void test_file_ring_resumes_from_checkpoint_after_crash(void **state)
+{
+    (void)state;
+    char path[128];
+    file_test_path(path, sizeof(path), "crash");
+
+    pid_t child = fork();
+    assert_true(child >= 0);
+    if(child == 0)
+    {
+        spsc_ring_t *ring = spsc_ring_open_file(path, 16);
+        if(ring == NULL) _exit(1);
+        for(int i = 0; i < 6; ++i) spsc_ring_push(ring, i);
+        int value;
+        spsc_ring_pop(ring, &value);
+        spsc_ring_pop(ring, &value);
+        if(spsc_ring_checkpoint(ring) != 0) _exit(2);
+        /* Progress after the checkpoint is not durable. */
+        spsc_ring_pop(ring, &value);
+        spsc_ring_push(ring, 6);
+        _exit(0);
+    }
+    int status = -1;
+    assert_int_equal(child, waitpid(child, &status, 0));
+    assert_true(WIFEXITED(status));
+    assert_int_equal(0, WEXITSTATUS(status));
+
+    /* Resume at the checkpointed consumer position: 2..5 again. */
+    spsc_ring_t *ring = spsc_ring_open_file(path, 16);
+    assert_non_null(ring);
+    int out[8];
+    assert_int_equal(4, spsc_ring_pop_bulk(ring, out, 8));
+    for(int i = 0; i < 4; ++i)
+    {
+        assert_int_equal(2 + i, out[i]);
+    }
+    spsc_ring_destroy(&ring);
+    unlink(path);
+}
+
+static void test_file_ring_producer_keeps_off_checkpointed_slots(void **state)
+{
+    (void)state;
+    char path[128];
+    file_test_path(path, sizeof(path), "wrap");
+
+    pid_t child = fork();
+    assert_true(child >= 0);
+    if(child == 0)
+    {
+        spsc_ring_t *ring = spsc_ring_open_file(path, 4);
+        if(ring == NULL) _exit(100);
+        for(int i = 0; i < 4; ++i) spsc_ring_push(ring, i);
+        int value;
+        spsc_ring_pop(ring, &value);
+        spsc_ring_pop(ring, &value);
+        if(spsc_ring_checkpoint(ring) != 0) _exit(101);
+        spsc_ring_pop(ring, &value);
+        spsc_ring_pop(ring, &value);
+        /* Only the slots behind the checkpointed head may be reused. */
+        int pushed = 0;
+        for(int i = 4; i < 8; ++i) pushed += (spsc_ring_push(ring, i) == 0);
+        _exit(pushed);   /* crash: no destroy, no final checkpoint */
+    }
+    int status = -1;
+    assert_int_equal(child, waitpid(child, &status, 0));
+    assert_true(WIFEXITED(status));
+    assert_int_equal(2, WEXITSTATUS(status));
+
+    /* Exactly what the checkpoint promised, not the later pushes. */
+    spsc_ring_t *ring = spsc_ring_open_file(path, 4);
+    assert_non_null(ring);
+    int out[4];
+    assert_int_equal(2, spsc_ring_pop_bulk(ring, out, 4));
+    assert_int_equal(2, out[0]);
+    assert_int_equal(3, out[1]);
+
+    /* The popped slots come back only with the next checkpoint. */
+    assert_int_equal(0, spsc_ring_push_bulk_all(ring, out, 2));
+    assert_int_equal(-1, spsc_ring_push(ring, 9));
+    assert_int_equal(0, spsc_ring_checkpoint(ring));
+    assert_int_equal(0, spsc_ring_push(ring, 9));
+    spsc_ring_destroy(&ring);
+    unlink(path);
+}
+
+static void test_file_ring_periodic_checkpoint(void **state)
+{
+    (void)state;
+    char path[128];
+    file_test_path(path, sizeof(path), "every");
+
+    spsc_ring_t *heap = spsc_ring_init(4);
+    assert_int_equal(-1, spsc_ring_checkpoint(heap));
+    assert_int_equal(EINVAL, errno);
+    assert_int_equal(-1, spsc_ring_checkpoint_every(heap, 0));
+    spsc_ring_destroy(&heap);
+
+    spsc_ring_t *ring = spsc_ring_open_file(path, 4);
+    assert_non_null(ring);
+    assert_int_equal(0, spsc_ring_checkpoint_every(ring, UINT64_MAX));
+    assert_int_equal(0, spsc_ring_push(ring, 1));
+    assert_int_equal(1, spsc_ring_checkpoint_every(ring, 0));
+    spsc_ring_destroy(&ring);
+    unlink(path);
+}
+
+static void test_ring_dir_create_lookup_attach(void **state)
+{
+    (void)state;
+    char name[64];
+    shm_test_name(name, sizeof(name), "dir");
+    spsc_ring_unlink_shm(name);
+
+    const spsc_ring_dir_spec_t specs[] = {
+        { "ingest.0",  8,    0 },
+        { "ingest.1",  64,   SPSC_RING_BLOCKING },
+        { "control",   2,    0 },
+    };
+    const spsc_ring_dir_spec_t dup[] = { { "a", 4, 0 }, { "a", 4, 0 } };
+    const spsc_ring_dir_spec_t bad[] = { { "a", 3, 0 } };
+    assert_null(spsc_ring_dir_create(name, dup, 2));
+    assert_int_equal(EINVAL, errno);
+    assert_null(spsc_ring_dir_create(name, bad, 1));
+    assert_null(spsc_ring_dir_create(name, specs, 0));
+
+    spsc_ring_dir_t *dir = spsc_ring_dir_create(name, specs, 3);
+    assert_non_null(dir);
+    assert_int_equal(3, spsc_ring_dir_count(dir));
+
+    spsc_ring_t *rings[3];
+    for(int i = 0; i < 3; ++i)
+    {
+        rings[i] = spsc_ring_dir_lookup(dir, specs[i].name);
+        assert_non_null(rings[i]);
+        assert_int_equal(0, (uintptr_t)rings[i] % SPSC_RING_CACHE_LINE);
+        assert_int_equal(specs[i].capacity, rings[i]->cfg.size);
+    }
+    assert_ptr_not_equal(rings[0], rings[1]);
+    assert_null(spsc_ring_dir_lookup(dir, "missing"));
+    assert_int_equal(ENOENT, errno);
+
+    /* A ring whose slot offset was tampered with fails the attach. */
+    int64_t buf_off = rings[0]->cfg.buf_off;
+    rings[0]->cfg.buf_off = -4096;
+    assert_null(spsc_ring_dir_attach(name));
+    assert_int_equal(EINVAL, errno);
+    rings[0]->cfg.buf_off = buf_off;
+
+    /* Rings are independent and visible through a second mapping. */
+    spsc_ring_dir_t *peer_dir = spsc_ring_dir_attach(name);
+    assert_non_null(peer_dir);
+    assert_int_equal(0, spsc_ring_unlink_shm(name));
+    for(int i = 0; i < 3; ++i)
+    {
+        assert_int_equal(0, spsc_ring_push(rings[i], 10 * i));
+    }
+    assert_int_equal(0, spsc_ring_push(rings[2], 21));
+    assert_true(spsc_ring_is_full(rings[2]));
+    for(int i = 2; i >= 0; --i)
+    {
+        spsc_ring_t *peer = spsc_ring_dir_lookup(peer_dir, specs[i].name);
+        assert_non_null(peer);
+        int value = -1;
+        assert_int_equal(0, spsc_ring_pop(peer, &value));
+        assert_int_equal(10 * i, value);
+    }
+    spsc_ring_t *blocking = spsc_ring_dir_lookup(peer_dir, "ingest.1");
+    int value = 0;
+    assert_int_equal(-1, spsc_ring_pop_wait(blocking, &value, 1000));
+    assert_int_equal(ETIMEDOUT, errno);
+
+    /* Destroying a looked-up ring only drops the pointer. */
+    spsc_ring_destroy(&blocking);
+    assert_null(blocking);
+    assert_int_equal(0, spsc_ring_push(rings[1], 5));
+
+    spsc_ring_dir_destroy(&peer_dir);
+    assert_null(peer_dir);
+
+    spsc_ring_dir_destroy(&dir);
+    spsc_ring_dir_destroy(NULL);
+}
+
+static void test_ring_dir_large_segment(void **state)
+{
+    (void)state;
+    char name[64];
+    shm_test_name(name, sizeof(name), "dirbig");
+    spsc_ring_unlink_shm(name);
+
+    /* Big enough to take the huge-page aligned mapping path. */
+    spsc_ring_dir_spec_t specs[4];
+    char names[4][16];
+    for(int i = 0; i < 4; ++i)
+    {
+        snprintf(names[i], sizeof(names[i]), "big.%d", i);
+        specs[i] = (spsc_ring_dir_spec_t){ names[i], 1u << 18, 0 };
+    }
+    spsc_ring_dir_t *dir = spsc_ring_dir_create(name, specs, 4);
+    assert_non_null(dir);
+    assert_int_equal(0, (uintptr_t)dir % (2u * 1024u * 1024u));
+    spsc_ring_dir_t *peer_dir = spsc_ring_dir_attach(name);
+    assert_non_null(peer_dir);
+    assert_int_equal(0, spsc_ring_unlink_shm(name));
+
+    /* The last ring sits at the same offset in both mappings. */
+    spsc_ring_t *last = spsc_ring_dir_lookup(dir, "big.3");
+    spsc_ring_t *peer = spsc_ring_dir_lookup(peer_dir, "big.3");
+    assert_non_null(last);
+    assert_non_null(peer);
+    assert_int_equal((uintptr_t)last - (uintptr_t)dir, (uintptr_t)peer - (uintptr_t)peer_dir);
+
+    /* Its last slot, at the very end of the segment, is shared too. */
+    spsc_ring_span_t first;
+    assert_int_equal(1u << 18, spsc_ring_reserve(last, 1u << 18, &first, NULL));
+    first.data[first.len - 1] = 42;
+    assert_int_equal(0, spsc_ring_commit(last, first.len));
+    assert_int_equal(42, spsc_ring_buf(peer)[(1u << 18) - 1]);
+
+    spsc_ring_dir_destroy(&peer_dir);
+    spsc_ring_dir_destroy(&dir);
+}
+
+static void test_magic_ring_spans_never_wrap(void **state)
+{
+    (void)state;
+    /* The slot array has to be a whole number of pages. */
+    assert_null(spsc_ring_init_ex(16, SPSC_RING_MAGIC));
+
+    spsc_ring_t *ring = spsc_ring_init_ex(1024, SPSC_RING_MAGIC);
+    assert_non_null(ring);
+
+    /* Both halves of the mapping alias the same slots. */
+    int *buf = spsc_ring_buf(ring);
+    buf[3] = 42;
+    assert_int_equal(42, buf[1024 + 3]);
+    buf[1024 + 5] = 7;
+    assert_int_equal(7, buf[5]);
+
+    static int src[1024];
+    static int dst[1024];
+    for(int i = 0; i < 1024; ++i) src[i] = i;
+
+    /* Move tail close to the end of buf, then cross it in one bulk call. */
+    assert_int_equal(1000, spsc_ring_push_bulk(ring, src, 1000));
+    assert_int_equal(1000, spsc_ring_pop_bulk(ring, dst, 1000));
+    assert_int_equal(100, spsc_ring_push_bulk(ring, src, 100));
+    assert_int_equal(100, spsc_ring_pop_bulk(ring, dst, 100));
+    assert_memory_equal(src, dst, 100 * sizeof(int));
+
+    /* Reserve and peek hand out one span even across the end of buf. */
+    spsc_ring_span_t first;
+    spsc_ring_span_t second;
+    assert_int_equal(200, spsc_ring_reserve(ring, 200, &first, &second));
+    assert_int_equal(200, first.len);
+    assert_int_equal(0, second.len);
+    for(uint32_t i = 0; i < first.len; ++i) first.data[i] = 500 + (int)i;
+    assert_int_equal(0, spsc_ring_commit(ring, 200));
+
+    spsc_ring_cspan_t rfirst;
+    assert_int_equal(200, spsc_ring_peek(ring, 300, &rfirst, NULL));
+    assert_int_equal(200, rfirst.len);
+    for(uint32_t i = 0; i < rfirst.len; ++i)
+    {
+        assert_int_equal(500 + (int)i, rfirst.data[i]);
+    }
+    assert_int_equal(0, spsc_ring_release(ring, 200));
+    assert_true(spsc_ring_is_empty(ring));
+
+    destroy_ring(&ring);
+}
+
+static void *msg_blocking_producer(void *arg)
+{
+    spsc_msg_ring_t *ring = arg;
+    uint32_t payload[8];
+    for(uint32_t i = 0; i < THREADED_ITEMS; ++i)
+    {
+        for(uint32_t k = 0; k < 8; ++k) payload[k] = i;
+        if(spsc_msg_ring_push_wait(ring, payload, (i % 8 + 1) * sizeof(uint32_t), -1) != 0)
+        {
+            return arg;
+        }
+    }
+    return NULL;
+}
+
+static void test_msg_ring_blocking_eventfd_lazy(void **state)
+{
+    (void)state;
+    uint32_t len = 0;
+    spsc_msg_ring_t *plain = spsc_msg_ring_init(64);
+    assert_int_equal(-1, spsc_msg_ring_push_wait(plain, "x", 1, 0));
+    assert_int_equal(EINVAL, errno);
+    assert_null(spsc_msg_ring_peek_wait(plain, &len, 0));
+    assert_int_equal(EINVAL, errno);
+    assert_int_equal(-1, spsc_msg_ring_get_eventfd(plain));
+    spsc_msg_ring_destroy(&plain);
+
+    spsc_msg_ring_t *ring = spsc_msg_ring_init_ex(64, SPSC_RING_BLOCKING | SPSC_RING_EVENTFD);
+    assert_non_null(ring);
+    int efd = spsc_msg_ring_get_eventfd(ring);
+    assert_true(efd >= 0);
+
+    /* Same eventfd edge as the int ring: empty -> non-empty signals once. */
+    assert_null(spsc_msg_ring_peek_wait(ring, &len, 1000000));
+    assert_int_equal(ETIMEDOUT, errno);
+    assert_false(eventfd_readable(efd));
+    assert_int_equal(0, spsc_msg_ring_push_wait(ring, "hello", 5, 0));
+    assert_int_equal(0, spsc_msg_ring_push(ring, "world", 5));
+    assert_true(eventfd_readable(efd));
+    assert_int_equal(0, spsc_msg_ring_eventfd_drain(ring));
+    assert_false(eventfd_readable(efd));
+
+    /* Four 16-byte records fill the ring: push_wait times out. */
+    assert_int_equal(0, spsc_msg_ring_push(ring, "abc", 3));
+    assert_int_equal(0, spsc_msg_ring_push(ring, "def", 3));
+    assert_int_equal(-1, spsc_msg_ring_push_wait(ring, "ghi", 3, 1000000));
+    assert_int_equal(ETIMEDOUT, errno);
+    while(spsc_msg_ring_release(ring) == 0) {}
+
+    /* Deferred tail: nothing visible until the batch fills or a flush. */
+    assert_int_equal(0, spsc_msg_ring_set_lazy(ring, 8, 0));
+    assert_int_equal(0, spsc_msg_ring_push(ring, "lazy", 4));
+    assert_true(spsc_msg_ring_is_empty(ring));
+    assert_int_equal(0, spsc_msg_ring_flush(ring));
+    const char *view = spsc_msg_ring_peek_wait(ring, &len, 0);
+    assert_non_null(view);
+    assert_int_equal(4, len);
+    assert_memory_equal("lazy", view, 4);
+    assert_int_equal(0, spsc_msg_ring_release(ring));
+    assert_int_equal(0, spsc_msg_ring_set_lazy(ring, 0, 0));
+    spsc_msg_ring_destroy(&ring);
+
+    /* Threaded handoff through the futex, wrapping with skip records. */
+    ring = spsc_msg_ring_init_ex(128, SPSC_RING_BLOCKING);
+    assert_non_null(ring);
+
+    pthread_t producer;
+    assert_int_equal(0, pthread_create(&producer, NULL, msg_blocking_producer, ring));
+
+    int mismatches = 0;
+    for(uint32_t expected = 0; expected < THREADED_ITEMS; ++expected)
+    {
+        const uint32_t *msg = spsc_msg_ring_peek_wait(ring, &len, -1);
+        assert_non_null(msg);
+        mismatches += (len != (expected % 8 + 1) * sizeof(uint32_t));
+        mismatches += (msg[len / sizeof(uint32_t) - 1] != expected);
+        assert_int_equal(0, spsc_msg_ring_release(ring));
+    }
+    void *result = ring;
+    assert_int_equal(0, pthread_join(producer, &result));
+    assert_null(result);
+    assert_int_equal(0, mismatches);
+    assert_true(spsc_msg_ring_is_empty(ring));
+
+    spsc_msg_ring_destroy(&ring);
+}
+
+static void test_msg_ring_magic_never_pads(void **state)
+{
+    (void)state;
+    assert_null(spsc_msg_ring_init_ex(64, SPSC_RING_MAGIC));
+    assert_null(spsc_msg_ring_init_ex(4096, SPSC_RING_SENTINEL));
+
+    spsc_msg_ring_t *ring = spsc_msg_ring_init_ex(4096, SPSC_RING_MAGIC);
+    assert_non_null(ring);
+    assert_int_equal(4096 - 8, spsc_msg_ring_max_msg(ring));
+
+    static uint8_t big[3000];
+    for(size_t i = 0; i < sizeof(big); ++i) big[i] = (uint8_t)i;
+
+    /*
+     * Each record is larger than half the ring, so from the second one on
+     * every record runs across the end of buf.
+     */
+    for(int round = 0; round < 5; ++round)
+    {
+        big[0] = (uint8_t)round;
+        assert_int_equal(0, spsc_msg_ring_push(ring, big, sizeof(big)));
+        assert_int_equal(-1, spsc_msg_ring_push(ring, big, sizeof(big)));
+
+        uint32_t len = 0;
+        const uint8_t *msg = spsc_msg_ring_peek(ring, &len);
+        assert_non_null(msg);
+        assert_int_equal(sizeof(big), len);
+        assert_memory_equal(big, msg, sizeof(big));
+        assert_int_equal(0, spsc_msg_ring_release(ring));
+        assert_true(spsc_msg_ring_is_empty(ring));
+    }
+
+    spsc_msg_ring_destroy(&ring);
+    assert_null(ring);
+}
+
+static void test_init_in_caller_memory(void **state)
+{
+    (void)state;
+    assert_int_equal(0, spsc_ring_required_size(0));
+    assert_int_equal(0, spsc_ring_required_size(6));
+    assert_int_equal(SPSC_RING_REQUIRED_SIZE(64), spsc_ring_required_size(64));
+
+    struct worker {
+        int id;
+        _Alignas(SPSC_RING_CACHE_LINE) unsigned char rx[SPSC_RING_REQUIRED_SIZE(64)];
+    } worker;
+
+    errno = 0;
+    assert_null(spsc_ring_init_in(worker.rx, sizeof(worker.rx) - 1, 64));
+    assert_int_equal(EINVAL, errno);
+    assert_null(spsc_ring_init_in(worker.rx + 8, sizeof(worker.rx) - 8, 32));
+    assert_null(spsc_ring_init_in(worker.rx, sizeof(worker.rx), 48));
+    assert_null(spsc_ring_init_in_ex(worker.rx, sizeof(worker.rx), 64, SPSC_RING_EVENTFD));
+    assert_null(spsc_ring_init_in(NULL, sizeof(worker.rx), 64));
+
+    /* Leftover bytes in the block do not leak into the new ring. */
+    memset(worker.rx, 0xA5, sizeof(worker.rx));
+    spsc_ring_t *ring = spsc_ring_init_in(worker.rx, sizeof(worker.rx), 64);
+    assert_ptr_equal(worker.rx, ring);
+    assert_true(spsc_ring_is_empty(ring));
+    for(int i = 0; i < 64; ++i)
+    {
+        assert_int_equal(0, spsc_ring_push(ring, i));
+    }
+    assert_true(spsc_ring_is_full(ring));
+    for(int i = 0; i < 64; ++i)
+    {
+        int value = -1;
+        assert_int_equal(0, spsc_ring_pop(ring, &value));
+        assert_int_equal(i, value);
+    }
+
+    /* The block stays the caller's: it can host a fresh ring right away. */
+    spsc_ring_destroy(&ring);
+    assert_null(ring);
+    ring = spsc_ring_init_in_ex(worker.rx, sizeof(worker.rx), 64, SPSC_RING_BLOCKING);
+    assert_non_null(ring);
+    int value = 0;
+    assert_int_equal(-1, spsc_ring_pop_wait(ring, &value, 1000));
+    assert_int_equal(ETIMEDOUT, errno);
+    spsc_ring_destroy(&ring);
+}
+
+SPSC_RING_DECLARE_STATIC(static_ring_mem, 128);
+
+static void test_static_ring_fills_its_block(void **state)
+{
+    (void)state;
+    assert_int_equal(0, (uintptr_t)static_ring_mem % SPSC_RING_CACHE_LINE);
+    assert_int_equal(spsc_ring_required_size(128), sizeof(static_ring_mem));
+
+    spsc_ring_t *ring = spsc_ring_init_in(static_ring_mem, sizeof(static_ring_mem), 128);
+    assert_ptr_equal(static_ring_mem, ring);
+
+    /* The slots end exactly at the end of the block. */
+    assert_ptr_equal(static_ring_mem + sizeof(static_ring_mem), spsc_ring_buf(ring) + 128);
+    assert_true(spsc_ring_is_empty(ring));
+
+    spsc_ring_destroy(&ring);
+    assert_null(ring);
+}
+
+static void test_heap_ring_slots_follow_structure(void **state)
+{
+    (void)state;
+    /* Each part of the structure starts a cache line of its own. */
+    assert_int_equal(0, offsetof(spsc_ring_t, cfg));
+    assert_int_equal(0, offsetof(spsc_ring_t, prod) % SPSC_RING_CACHE_LINE);
+    assert_int_equal(0, offsetof(spsc_ring_t, cons) % SPSC_RING_CACHE_LINE);
+    assert_int_equal(0, offsetof(spsc_ring_t, wait) % SPSC_RING_CACHE_LINE);
+    assert_true(sizeof(((spsc_ring_t *)0)->cfg) <= offsetof(spsc_ring_t, prod));
+    assert_true(offsetof(spsc_ring_t, prod) + sizeof(((spsc_ring_t *)0)->prod) <=
+                offsetof(spsc_ring_t, cons));
+    assert_true(offsetof(spsc_ring_t, cons) + sizeof(((spsc_ring_t *)0)->cons) <=
+                offsetof(spsc_ring_t, wait));
+    assert_int_equal(0, sizeof(spsc_ring_t) % SPSC_RING_CACHE_LINE);
+
+    spsc_ring_t *ring = create_ring(1u << 16);
+
+    /* One block: the slots start on the first line behind the wait line. */
+    unsigned char *base  = (unsigned char *)ring;
+    unsigned char *slots = (unsigned char *)spsc_ring_buf(ring);
+    assert_int_equal(0, (uintptr_t)ring % SPSC_RING_CACHE_LINE);
+    assert_int_equal(0, (uintptr_t)slots % SPSC_RING_CACHE_LINE);
+    assert_int_equal(sizeof(spsc_ring_t), ring->cfg.buf_off);
+    assert_ptr_equal(base + sizeof(spsc_ring_t), slots);
+    assert_true(base + offsetof(spsc_ring_t, wait) + sizeof(ring->wait) <= slots);
+
+    /* Writing the first slot leaves the structure alone. */
+    spsc_ring_t before = *ring;
+    spsc_ring_buf(ring)[0] = 7;
+    assert_memory_equal(&before, ring, sizeof(before));
+
+    destroy_ring(&ring);
+}
+
+/* Locked memory of this process in KiB, from /proc/self/status */
+static long locked_kib(void)
+{
+    FILE *f = fopen("/proc/self/status", "r");
+    char line[128];
+    long kib = -1;
+    while(f != NULL && fgets(line, sizeof(line), f) != NULL)
+    {
+        if(sscanf(line, "VmLck: %ld kB", &kib) == 1) break;
+    }
+    if(f != NULL) fclose(f);
+    return kib;
+}
+
+/* Whether every page of [addr, addr + bytes) is resident, from mincore() */
+static int all_pages_resident(const void *addr, size_t bytes)
+{
+    size_t page  = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = (size_t)(uintptr_t)addr & ~(page - 1);
+    size_t pages = ((size_t)(uintptr_t)addr + bytes - start + page - 1) / page;
+    unsigned char vec[4096];
+    if(pages > sizeof(vec) || mincore((void *)start, pages * page, vec) != 0) return 0;
+    for(size_t i = 0; i < pages; ++i)
+    {
+        if(!(vec[i] & 1)) return 0;
+    }
+    return 1;
+}
+
+/* Whether this system can back memory with huge pages at all */
+static int huge_pages_available(void)
+{
+    char line[128];
+    long pool = 0;
+    FILE *f = fopen("/proc/meminfo", "r");
+    while(f != NULL && fgets(line, sizeof(line), f) != NULL)
+    {
+        if(sscanf(line, "HugePages_Free: %ld", &pool) == 1) break;
+    }
+    if(f != NULL) fclose(f);
+
+    int thp = 0;
+    f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if(f != NULL && fgets(line, sizeof(line), f) != NULL)
+    {
+        thp = (strstr(line, "[never]") == NULL);
+    }
+    if(f != NULL) fclose(f);
+    return pool > 0 || thp;
+}
+
+/*
+ * Whether the mapping holding addr is backed by huge pages, from its
+ * /proc/self/smaps entry: hugetlbfs pages (KernelPageSize above 4 kB) or
+ * transparent ones (AnonHugePages)
+ */
+static int mapping_has_huge_pages(const void *addr)
+{
+    FILE *f = fopen("/proc/self/smaps", "r");
+    if(f == NULL) return 0;
+
+    char line[512];
+    int  inside = 0;
+    long kib    = 0;
+    int  huge   = 0;
+    while(fgets(line, sizeof(line), f) != NULL)
+    {
+        unsigned long lo, hi;
+        if(sscanf(line, "%lx-%lx ", &lo, &hi) == 2)
+        {
+            if(inside) break;
+            inside = ((uintptr_t)addr >= lo && (uintptr_t)addr < hi);
+        }
+        else if(inside && sscanf(line, "AnonHugePages: %ld kB", &kib) == 1 && kib > 0)
+        {
+            huge = 1;
+        }
+        else if(inside && sscanf(line, "KernelPageSize: %ld kB", &kib) == 1 && kib > 4)
+        {
+            huge = 1;
+        }
+    }
+    fclose(f);
+    return huge;
+}
+
+static void test_page_flags_hugepage_populate(void **state)
+{
+    (void)state;
+    /* Works whether or not the system has a huge page pool. */
+    spsc_ring_t *ring = spsc_ring_init_ex(1u << 20, SPSC_RING_HUGEPAGE | SPSC_RING_POPULATE);
+    assert_non_null(ring);
+    assert_int_equal(0, (uintptr_t)ring % 4096);
+    assert_ptr_equal((unsigned char *)ring + sizeof(spsc_ring_t), spsc_ring_buf(ring));
+
+    /* POPULATE: every page was faulted in before init returned. */
+    assert_true(all_pages_resident(ring, SPSC_RING_REQUIRED_SIZE(1u << 20)));
+
+    /* HUGEPAGE: the block sits on huge pages, explicit or transparent. */
+    if(huge_pages_available())
+    {
+        assert_true(mapping_has_huge_pages(spsc_ring_buf(ring)));
+    }
+    destroy_ring(&ring);
+
+    /* Without POPULATE the block is only faulted in as it is used. */
+    ring = spsc_ring_init_ex(1u << 20, SPSC_RING_HUGEPAGE);
+    assert_non_null(ring);
+    assert_false(all_pages_resident(ring, SPSC_RING_REQUIRED_SIZE(1u << 20)));
+    destroy_ring(&ring);
+
+    /* The page flags also apply to the slot mapping of a magic ring. */
+    ring = spsc_ring_init_ex(4096, SPSC_RING_MAGIC | SPSC_RING_POPULATE | SPSC_RING_HUGEPAGE);
+    assert_non_null(ring);
+    int src[64] = {0};
+    assert_int_equal(64, spsc_ring_push_bulk(ring, src, 64));
+    destroy_ring(&ring);
+
+    /* Huge page sizes are read from the system, not assumed to be 2 MiB. */
+    for(int thp = 0; thp < 2; ++thp)
+    {
+        uint64_t huge = spsc_pages_huge_size(thp);
+        assert_true(huge >= 4096 && (huge & (huge - 1)) == 0);
+    }
+    FILE *meminfo = fopen("/proc/meminfo", "r");
+    if(meminfo)
+    {
+        char line[128];
+        unsigned long long kb = 0;
+        while(fgets(line, sizeof(line), meminfo) && sscanf(line, "Hugepagesize: %llu kB", &kb) != 1) {}
+        fclose(meminfo);
+        if(kb)
+        {
+            assert_int_equal(kb * 1024u, spsc_pages_huge_size(0));
+        }
+    }
+}
+
+static void test_page_flags_mlock(void **state)
+{
+    (void)state;
+    long before = locked_kib();
+    errno = 0;
+    spsc_ring_t *ring = spsc_ring_init_ex(1u << 14, SPSC_RING_MLOCK | SPSC_RING_BLOCKING);
+    if(ring == NULL)
+    {
+        /* Not allowed to lock that much here; the failure must say why. */
+        assert_true(errno == ENOMEM || errno == EPERM || errno == EAGAIN);
+        return;
+    }
+    if(before >= 0)
+    {
+        assert_true(locked_kib() - before >= (long)(SPSC_RING_REQUIRED_SIZE(1u << 14) / 1024));
+    }
+    assert_int_equal(0, spsc_ring_push(ring, 9));
+    int value = 0;
+    assert_int_equal(0, spsc_ring_pop_wait(ring, &value, 1000));
+    assert_int_equal(9, value);
+    destroy_ring(&ring);
+    if(before >= 0)
+    {
+        assert_int_equal(before, locked_kib());
+    }
+}
+
+static void test_init_numa_binds_to_cpu_node(void **state)
+{
+    (void)state;
+    errno = 0;
+    assert_null(spsc_ring_init_numa(1024, -1, 0));
+    assert_int_equal(EINVAL, errno);
+    assert_null(spsc_ring_init_numa(1024, 0, 1 << 20));
+    assert_null(spsc_ring_init_numa(1000, 0, 0));
+    assert_null(spsc_ring_init_numa_ex(1024, 0, 0, 0, 7));
+    assert_null(spsc_ring_init_numa_ex(1024, 0, 0, SPSC_RING_MAGIC, SPSC_RING_NUMA_CONSUMER));
+
+    spsc_ring_t *ring = spsc_ring_init_numa(1u << 16, 0, 0);
+    assert_non_null(ring);
+    int *buf = spsc_ring_buf(ring);
+    buf[(1u << 16) - 1] = 1;
+
+    /* The last slot's page was faulted after the binding: it is on cpu0's node. */
+    int node = -1;
+    if(syscall(SYS_get_mempolicy, &node, NULL, 0UL, &buf[(1u << 16) - 1], 3UL) == 0)
+    {
+        int expected = 0;
+        char path[64];
+        for(int n = 0; n < 64; ++n)
+        {
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/node%d", n);
+            if(access(path, F_OK) == 0) { expected = n; break; }
+        }
+        assert_int_equal(expected, node);
+    }
+
+    for(int i = 0; i < 100; ++i) assert_int_equal(0, spsc_ring_push(ring, i));
+    for(int i = 0; i < 100; ++i)
+    {
+        int value = -1;
+        assert_int_equal(0, spsc_ring_pop(ring, &value));
+        assert_int_equal(i, value);
+    }
+    destroy_ring(&ring);
+
+    ring = spsc_ring_init_numa_ex(1u << 12, 0, 0, SPSC_RING_BLOCKING | SPSC_RING_POPULATE,
+                                  SPSC_RING_NUMA_INTERLEAVE);
+    assert_non_null(ring);
+    int value = 0;
+    assert_int_equal(-1, spsc_ring_pop_wait(ring, &value, 1000));
+    destroy_ring(&ring);
+}
+
+static void test_lazy_tail_publication(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = create_ring(64);
+    assert_int_equal(-1, spsc_ring_set_lazy(NULL, 8, 0));
+    assert_int_equal(0, spsc_ring_set_lazy(ring, 8, 0));
+
+    /* Seven elements stay private to the producer, the eighth publishes all. */
+    int value = -1;
+    for(int i = 0; i < 7; ++i) assert_int_equal(0, spsc_ring_push(ring, i));
+    assert_int_equal(-1, spsc_ring_pop(ring, &value));
+    assert_int_equal(0, spsc_ring_push(ring, 7));
+    for(int i = 0; i < 8; ++i)
+    {
+        assert_int_equal(0, spsc_ring_pop(ring, &value));
+        assert_int_equal(i, value);
+    }
+
+    /* An explicit flush publishes a partial batch. */
+    assert_int_equal(0, spsc_ring_push(ring, 100));
+    assert_true(spsc_ring_is_empty(ring));
+    assert_int_equal(0, spsc_ring_flush(ring));
+    assert_int_equal(0, spsc_ring_pop(ring, &value));
+    assert_int_equal(100, value);
+    /* A consumer that finds the ring empty hands its slots back. */
+    assert_true(spsc_ring_is_empty(ring));
+
+    /* A producer that runs into a full ring publishes what it holds. */
+    assert_int_equal(0, spsc_ring_set_lazy(ring, 50, 0));
+    int src[64];
+    for(int i = 0; i < 64; ++i) src[i] = i;
+    for(int i = 0; i < 64; ++i) assert_int_equal(0, spsc_ring_push(ring, src[i]));
+    assert_int_equal(-1, spsc_ring_push(ring, 64));
+    int dst[64];
+    assert_int_equal(0, spsc_ring_pop_bulk_all(ring, dst, 64));
+    assert_memory_equal(src, dst, sizeof(src));
+
+    /* Time bound: once the delay has passed, the push that completes the
+     * current SPSC_RING_LAZY_STRIDE publishes everything pending. */
+    assert_int_equal(0, spsc_ring_set_lazy(ring, 64, 1000000));
+    assert_int_equal(0, spsc_ring_push(ring, 1));
+    assert_true(spsc_ring_is_empty(ring));
+    struct timespec pause = { 0, 2000000 };
+    nanosleep(&pause, NULL);
+    for(int i = 2; i < (int)SPSC_RING_LAZY_STRIDE; ++i)
+    {
+        assert_int_equal(0, spsc_ring_push(ring, i));
+        assert_true(spsc_ring_is_empty(ring));
+    }
+    assert_int_equal(0, spsc_ring_push(ring, (int)SPSC_RING_LAZY_STRIDE));
+    for(int i = 1; i <= (int)SPSC_RING_LAZY_STRIDE; ++i)
+    {
+        assert_int_equal(0, spsc_ring_pop(ring, &value));
+        assert_int_equal(i, value);
+    }
+
+    /* Switching it off publishes what is pending. */
+    assert_int_equal(0, spsc_ring_push(ring, 3));
+    assert_int_equal(0, spsc_ring_set_lazy(ring, 0, 0));
+    assert_int_equal(0, spsc_ring_pop(ring, &value));
+    assert_int_equal(3, value);
+
+    destroy_ring(&ring);
+}
+
+static void test_lazy_head_returns_in_quarter_batches(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = create_ring(64);
+    assert_int_equal(0, spsc_ring_set_lazy(ring, 4, 0));
+
+    for(int i = 0; i < 64; ++i) assert_int_equal(0, spsc_ring_push(ring, i));
+    assert_true(spsc_ring_is_full(ring));
+
+    /* Fewer than size / 4 pops do not free anything for the producer yet. */
+    int value = -1;
+    for(int i = 0; i < 15; ++i) assert_int_equal(0, spsc_ring_pop(ring, &value));
+    assert_true(spsc_ring_is_full(ring));
+    assert_int_equal(0, spsc_ring_pop(ring, &value));
+    assert_int_equal(15, value);
+    assert_false(spsc_ring_is_full(ring));
+
+    /* Draining the ring hands every slot back. */
+    while(spsc_ring_pop(ring, &value) == 0) { }
+    assert_int_equal(63, value);
+    for(int i = 0; i < 64; ++i) assert_int_equal(0, spsc_ring_push(ring, i));
+
+    destroy_ring(&ring);
+}
+
+static void *lazy_producer(void *arg)
+{
+    spsc_ring_t *ring = arg;
+    for(int i = 0; i < 200000; ++i)
+    {
+        while(spsc_ring_push(ring, i) != 0) { }
+    }
+    spsc_ring_flush(ring);
+    return NULL;
+}
+
+static void test_lazy_threaded_fifo(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = create_ring(256);
+    assert_int_equal(0, spsc_ring_set_lazy(ring, 32, 50000));
+
+    pthread_t producer;
+    assert_int_equal(0, pthread_create(&producer, NULL, lazy_producer, ring));
+    int mismatches = 0;
+    for(int i = 0; i < 200000; ++i)
+    {
+        int value = -1;
+        while(spsc_ring_pop(ring, &value) != 0) { }
+        mismatches += (value != i);
+    }
+    pthread_join(producer, NULL);
+    assert_int_equal(0, mismatches);
+    assert_true(spsc_ring_is_empty(ring));
+
+    destroy_ring(&ring);
+}
+
+static void test_sentinel_ring_fifo_without_indices(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = spsc_ring_init_ex(8, SPSC_RING_SENTINEL);
+    assert_non_null(ring);
+    assert_true(spsc_ring_is_empty(ring));
+
+    /* Fill, wrap and drain twice; the free marker cannot be pushed. */
+    int value = 0;
+    assert_int_equal(-1, spsc_ring_push(ring, SPSC_RING_EMPTY_SLOT));
+    for(int round = 0; round < 2; ++round)
+    {
+        for(int i = 0; i < 8; ++i) assert_int_equal(0, spsc_ring_push(ring, round * 8 + i));
+        assert_true(spsc_ring_is_full(ring));
+        assert_int_equal(-1, spsc_ring_push(ring, 99));
+        for(int i = 0; i < 8; ++i)
+        {
+            assert_int_equal(0, spsc_ring_pop(ring, &value));
+            assert_int_equal(round * 8 + i, value);
+        }
+        assert_int_equal(-1, spsc_ring_pop(ring, &value));
+    }
+
+    /* The shared indices were never written. */
+    assert_int_equal(0, atomic_load(&ring->prod.tail));
+    assert_int_equal(0, atomic_load(&ring->cons.head));
+    assert_int_equal(16, ring->prod.local.next);
+    assert_int_equal(16, ring->cons.local.next);
+
+    /* Features built on the indices are refused. */
+    spsc_ring_span_t  span;
+    spsc_ring_cspan_t cspan;
+    assert_int_equal(0, spsc_ring_push(ring, 1));
+    assert_int_equal(0, spsc_ring_reserve(ring, 1, &span, NULL));
+    assert_int_equal(0, spsc_ring_peek(ring, 1, &cspan, NULL));
+    assert_int_equal(-1, spsc_ring_release(ring, 1));
+    assert_int_equal(-1, spsc_ring_set_lazy(ring, 4, 0));
+    assert_int_equal(0, spsc_ring_pop(ring, &value));
+    assert_int_equal(1, value);
+
+    destroy_ring(&ring);
+
+    assert_null(spsc_ring_init_ex(8, SPSC_RING_SENTINEL | SPSC_RING_BLOCKING));
+    assert_null(spsc_ring_init_ex(8, SPSC_RING_SENTINEL | SPSC_RING_EVENTFD));
+    assert_null(spsc_ring_init_ex(1024, SPSC_RING_SENTINEL | SPSC_RING_MAGIC));
+    ring = spsc_ring_init(8);
+    assert_int_equal(-1, spsc_ring_set_probe(ring, 4));
+    destroy_ring(&ring);
+}
+
+static void test_sentinel_ring_probe_and_bulk(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = spsc_ring_init_ex(16, SPSC_RING_SENTINEL);
+    assert_non_null(ring);
+    assert_int_equal(-1, spsc_ring_set_probe(ring, 0));
+    assert_int_equal(0, spsc_ring_set_probe(ring, 8));
+
+    /* Three elements: the probe backs off from 8 to 2, then to 1. */
+    int src[16];
+    int dst[16];
+    for(int i = 0; i < 16; ++i) src[i] = 100 + i;
+    assert_int_equal(3, spsc_ring_push_bulk(ring, src, 3));
+    int value = 0;
+    for(int i = 0; i < 3; ++i)
+    {
+        assert_int_equal(0, spsc_ring_pop(ring, &value));
+        assert_int_equal(100 + i, value);
+    }
+    assert_true(spsc_ring_is_empty(ring));
+
+    /* All-or-nothing calls take the whole run or nothing. */
+    assert_int_equal(0, spsc_ring_push_bulk_all(ring, src, 16));
+    assert_int_equal(-1, spsc_ring_push_bulk_all(ring, src, 1));
+    assert_int_equal(0, spsc_ring_pop_bulk_all(ring, dst, 10));
+    assert_memory_equal(src, dst, 10 * sizeof(int));
+    assert_int_equal(-1, spsc_ring_pop_bulk_all(ring, dst, 7));
+    /* Best effort takes what the probe proved filled, 4 of the 6 here. */
+    assert_int_equal(4, spsc_ring_pop_bulk(ring, dst, 16));
+    assert_int_equal(2, spsc_ring_pop_bulk(ring, dst + 4, 16));
+    assert_memory_equal(src + 10, dst, 6 * sizeof(int));
+    assert_true(spsc_ring_is_empty(ring));
+
+    /* A best-effort push stops at the free marker, an all-or-nothing one refuses it. */
+    src[2] = SPSC_RING_EMPTY_SLOT;
+    assert_int_equal(-1, spsc_ring_push_bulk_all(ring, src, 4));
+    assert_int_equal(2, spsc_ring_push_bulk(ring, src, 4));
+    assert_int_equal(2, spsc_ring_pop_bulk(ring, dst, 4));
+    assert_int_equal(101, dst[1]);
+
+    destroy_ring(&ring);
+}
+
+static void *sentinel_producer(void *arg)
+{
+    spsc_ring_t *ring = arg;
+    for(int i = 0; i < 200000; ++i)
+    {
+        while(spsc_ring_push(ring, i) != 0) { }
+    }
+    return NULL;
+}
+
+static void test_sentinel_ring_threaded_fifo(void **state)
+{
+    (void)state;
+    for(uint32_t probe = 1; probe <= 32; probe *= 32)
+    {
+        spsc_ring_t *ring = spsc_ring_init_ex(256, SPSC_RING_SENTINEL);
+        assert_non_null(ring);
+        assert_int_equal(0, spsc_ring_set_probe(ring, probe));
+
+        pthread_t producer;
+        assert_int_equal(0, pthread_create(&producer, NULL, sentinel_producer, ring));
+        int mismatches = 0;
+        for(int i = 0; i < 200000; ++i)
+        {
+            int value = -1;
+            while(spsc_ring_pop(ring, &value) != 0) { }
+            mismatches += (value != i);
+        }
+        pthread_join(producer, NULL);
+        assert_int_equal(0, mismatches);
+        assert_true(spsc_ring_is_empty(ring));
+
+        destroy_ring(&ring);
+    }
+}
+
+static void test_prefetch_distance_keeps_fifo(void **state)
+{
+    (void)state;
+    assert_int_equal(-1, spsc_ring_set_prefetch(NULL, 8));
+
+    /* Prefetch windows that wrap, run past tail and cover whole batches. */
+    uint32_t flags[] = { 0, SPSC_RING_SENTINEL };
+    for(size_t f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f)
+    {
+        spsc_ring_t *ring = spsc_ring_init_ex(64, flags[f]);
+        assert_non_null(ring);
+        assert_int_equal(0, spsc_ring_set_prefetch(ring, 1000));
+        assert_int_equal(64, ring->prod.local.prefetch);
+        assert_int_equal(0, spsc_ring_set_prefetch(ring, 24));
+
+        int src[40];
+        int dst[40];
+        int next_in = 0;
+        int next_out = 0;
+        for(int round = 0; round < 20; ++round)
+        {
+            for(int i = 0; i < 40; ++i) src[i] = next_in + i;
+            uint32_t pushed = spsc_ring_push_bulk(ring, src, 40);
+            next_in += (int)pushed;
+            while(spsc_ring_push(ring, next_in) == 0) next_in++;
+
+            int value = -1;
+            assert_int_equal(0, spsc_ring_pop(ring, &value));
+            assert_int_equal(next_out++, value);
+            uint32_t popped = spsc_ring_pop_bulk(ring, dst, 40);
+            for(uint32_t i = 0; i < popped; ++i) assert_int_equal(next_out++, dst[i]);
+        }
+        int value = -1;
+        while(spsc_ring_pop(ring, &value) == 0) assert_int_equal(next_out++, value);
+        assert_int_equal(next_in, next_out);
+
+        destroy_ring(&ring);
+    }
+
+    /* Typed rings: every line of a 64-byte record is hinted. */
+    record_ring_t *records = record_ring_init(8);
+    assert_non_null(records);
+    assert_int_equal(-1, record_ring_set_prefetch(NULL, 2));
+    assert_int_equal(0, record_ring_set_prefetch(records, 3));
+    test_record_t in;
+    test_record_t out;
+    memset(&in, 0, sizeof(in));
+    for(uint64_t i = 0; i < 100; ++i)
+    {
+        in.seq = i;
+        assert_int_equal(0, record_ring_push(records, in));
+        assert_int_equal(0, record_ring_pop(records, &out));
+        assert_int_equal(i, out.seq);
+    }
+    record_ring_destroy(&records);
+}
+
+static void test_copy_kernels_match_memcpy(void **state)
+{
+    (void)state;
+    assert_int_equal(-1, spsc_ring_copy_select("mmx"));
+    assert_int_equal(EINVAL, errno);
+
+    static uint8_t src[5000];
+    static uint8_t dst[5100];
+    for(size_t i = 0; i < sizeof(src); ++i) src[i] = (uint8_t)(i * 7 + 3);
+
+    /* Every size up to a few vectors, at every alignment, plus a large run. */
+    const char *kernels[] = { "avx512", "avx2", "sse2", "scalar" };
+    for(size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k)
+    {
+        if(spsc_ring_copy_select(kernels[k]) != 0) continue;
+        assert_string_equal(kernels[k], spsc_ring_copy_kernel());
+        for(size_t off = 0; off < 8; ++off)
+        {
+            for(size_t len = 0; len <= 300; len += (len < 70) ? 1 : 23)
+            {
+                memset(dst, 0xEE, sizeof(dst));
+                spsc_ring_copy(dst + off, src + 1, len);
+                assert_memory_equal(src + 1, dst + off, len);
+                assert_int_equal(0xEE, dst[off + len]);
+
+                memset(dst, 0xEE, sizeof(dst));
+                spsc_ring_copy_stream(dst + off, src + 1, len);
+                assert_memory_equal(src + 1, dst + off, len);
+                assert_int_equal(0xEE, dst[off + len]);
+            }
+            spsc_ring_copy_stream(dst + off, src, sizeof(src));
+            assert_memory_equal(src, dst + off, sizeof(src));
+        }
+    }
+    assert_int_equal(0, spsc_ring_copy_select(NULL));
+    assert_non_null(spsc_ring_copy_kernel());
+}
+
+static void test_streaming_bulk_pushes(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = create_ring(256);
+    assert_int_equal(-1, spsc_ring_set_stream(NULL, 64));
+    assert_int_equal(0, spsc_ring_set_stream(ring, 64));
+
+    /* Batches above the threshold stream, smaller ones do not; both wrap. */
+    int src[200];
+    int dst[200];
+    for(int round = 0; round < 4; ++round)
+    {
+        for(int i = 0; i < 200; ++i) src[i] = round * 1000 + i;
+        assert_int_equal(0, spsc_ring_push_bulk_all(ring, src, 200));
+        assert_int_equal(0, spsc_ring_push_bulk_all(ring, src, 3));
+        assert_int_equal(0, spsc_ring_pop_bulk_all(ring, dst, 200));
+        assert_memory_equal(src, dst, sizeof(src));
+        assert_int_equal(0, spsc_ring_pop_bulk_all(ring, dst, 3));
+        assert_memory_equal(src, dst, 3 * sizeof(int));
+    }
+    destroy_ring(&ring);
+
+    ring = spsc_ring_init_ex(8, SPSC_RING_SENTINEL);
+    assert_int_equal(-1, spsc_ring_set_stream(ring, 64));
+    destroy_ring(&ring);
+
+    /* Message payloads at or above the threshold stream. */
+    spsc_msg_ring_t *msgs = spsc_msg_ring_init(4096);
+    assert_non_null(msgs);
+    assert_int_equal(-1, spsc_msg_ring_set_stream(NULL, 128));
+    assert_int_equal(0, spsc_msg_ring_set_stream(msgs, 128));
+    uint8_t payload[1000];
+    for(size_t i = 0; i < sizeof(payload); ++i) payload[i] = (uint8_t)i;
+    for(uint32_t len = 1; len < sizeof(payload); len += 97)
+    {
+        assert_int_equal(0, spsc_msg_ring_push(msgs, payload, len));
+        uint32_t got = 0;
+        const void *view = spsc_msg_ring_peek(msgs, &got);
+        assert_non_null(view);
+        assert_int_equal(len, got);
+        assert_memory_equal(payload, view, len);
+        assert_int_equal(0, spsc_msg_ring_release(msgs));
+    }
+    spsc_msg_ring_destroy(&msgs);
+
+    /* Typed rings take the library kernels through their copy hooks. */
+    record_ring_t *records = record_ring_init(8);
+    assert_non_null(records);
+    assert_null(records->cfg.copy_in);   /* Plain memcpy() until a hook is set */
+    assert_null(records->cfg.copy_out);
+    assert_int_equal(0, record_ring_set_copy(records, spsc_ring_copy_stream, spsc_ring_copy));
+    test_record_t batch[6];
+    test_record_t out[6];
+    memset(batch, 0, sizeof(batch));
+    for(int round = 0; round < 3; ++round)
+    {
+        for(uint32_t i = 0; i < 6; ++i) batch[i].seq = (uint64_t)round * 10 + i;
+        assert_int_equal(0, record_ring_push_bulk_all(records, batch, 6));
+        assert_int_equal(0, record_ring_pop_bulk_all(records, out, 6));
+        assert_memory_equal(batch, out, sizeof(batch));
+    }
+    assert_int_equal(0, record_ring_set_copy(records, NULL, NULL));
+    assert_null(records->cfg.copy_in);
+    assert_null(records->cfg.copy_out);
+    assert_int_equal(0, record_ring_push_bulk_all(records, batch, 6));
+    assert_int_equal(0, record_ring_pop_bulk_all(records, out, 6));
+    assert_memory_equal(batch, out, sizeof(batch));
+    record_ring_destroy(&records);
+}
+
+static void test_endpoints_open_once_and_write_back(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = create_ring(8);
+
+    errno = 0;
+    assert_null(spsc_ring_open_producer(NULL));
+    assert_int_equal(EINVAL, errno);
+    assert_int_equal(-1, spsc_ring_producer_is_full(NULL));
+    assert_int_equal(-1, spsc_ring_consumer_is_empty(NULL));
+
+    spsc_ring_producer_t *tx = spsc_ring_open_producer(ring);
+    spsc_ring_consumer_t *rx = spsc_ring_open_consumer(ring);
+    assert_non_null(tx);
+    assert_non_null(rx);
+    assert_int_equal(0, (uintptr_t)tx % SPSC_RING_CACHE_LINE);
+    assert_int_equal(0, (uintptr_t)rx % SPSC_RING_CACHE_LINE);
+    errno = 0;
+    assert_null(spsc_ring_open_producer(ring));
+    assert_int_equal(EBUSY, errno);
+    errno = 0;
+    assert_null(spsc_ring_open_consumer(ring));
+    assert_int_equal(EBUSY, errno);
+
+    /* The handles work on their own copy of the side state */
+    for(int i = 0; i < 8; ++i)
+    {
+        assert_int_equal(0, spsc_ring_producer_push(tx, i));
+    }
+    assert_true(spsc_ring_producer_is_full(tx));
+    assert_int_equal(-1, spsc_ring_producer_push_inline(tx, 8));
+    assert_int_equal(0, ring->prod.local.next);
+
+    int value = -1;
+    assert_int_equal(0, spsc_ring_consumer_pop(rx, &value));
+    assert_int_equal(0, value);
+    assert_int_equal(0, spsc_ring_consumer_pop_inline(rx, &value));
+    assert_int_equal(1, value);
+    assert_int_equal(0, spsc_ring_producer_push(tx, 8));
+
+    /* Closing hands the state back to the ring and frees the side */
+    spsc_ring_close_producer(&tx);
+    spsc_ring_close_consumer(&rx);
+    assert_null(tx);
+    assert_null(rx);
+    spsc_ring_close_producer(&tx);
+    spsc_ring_close_consumer(NULL);
+    assert_int_equal(9, ring->prod.local.next);
+    assert_int_equal(2, ring->cons.local.next);
+    assert_int_equal(0, spsc_ring_push(ring, 9));
+    assert_true(spsc_ring_is_full(ring));
+    assert_int_equal(0, spsc_ring_pop(ring, &value));
+    assert_int_equal(2, value);
+
+    rx = spsc_ring_open_consumer(ring);
+    assert_non_null(rx);
+    for(int i = 3; i <= 9; ++i)
+    {
+        assert_int_equal(0, spsc_ring_consumer_pop(rx, &value));
+        assert_int_equal(i, value);
+    }
+    assert_true(spsc_ring_consumer_is_empty(rx));
+    spsc_ring_close_consumer(&rx);
+    assert_true(spsc_ring_is_empty(ring));
+
+    destroy_ring(&ring);
+}
+
+static void test_endpoints_bulk_reserve_peek(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = create_ring(16);
+    assert_int_equal(0, spsc_ring_set_lazy(ring, 4, 0));
+    spsc_ring_producer_t *tx = spsc_ring_open_producer(ring);
+    spsc_ring_consumer_t *rx = spsc_ring_open_consumer(ring);
+    assert_non_null(tx);
+    assert_non_null(rx);
+
+    const int src[6] = {10, 11, 12, 13, 14, 15};
+    assert_int_equal(3, spsc_ring_producer_push_bulk(tx, src, 3));
+    assert_true(spsc_ring_consumer_is_empty(rx));   /* not published yet */
+    assert_int_equal(0, spsc_ring_producer_flush(tx));
+    assert_int_equal(0, spsc_ring_producer_push_bulk_all(tx, src + 3, 3));
+    assert_int_equal(-1, spsc_ring_producer_push_bulk_all(tx, src, 11));
+    assert_int_equal(0, spsc_ring_producer_flush(tx));
+
+    spsc_ring_span_t first, second;
+    assert_int_equal(4, spsc_ring_producer_reserve(tx, 4, &first, &second));
+    for(uint32_t i = 0; i < first.len; ++i) first.data[i] = 20 + (int)i;
+    assert_int_equal(-1, spsc_ring_producer_commit(tx, 5));
+    assert_int_equal(0, spsc_ring_producer_commit(tx, 4));
+    assert_int_equal(0, spsc_ring_producer_flush(tx));
+
+    int dst[6] = {0};
+    assert_int_equal(0, spsc_ring_consumer_pop_bulk_all(rx, dst, 6));
+    assert_memory_equal(src, dst, sizeof(src));
+
+    spsc_ring_cspan_t view, wrap;
+    assert_int_equal(4, spsc_ring_consumer_peek(rx, 8, &view, &wrap));
+    assert_int_equal(20, view.data[0]);
+    assert_int_equal(23, view.data[3]);
+    assert_int_equal(-1, spsc_ring_consumer_release(rx, 5));
+    assert_int_equal(0, spsc_ring_consumer_release(rx, 2));
+    assert_int_equal(2, spsc_ring_consumer_pop_bulk(rx, dst, 6));
+    assert_int_equal(22, dst[0]);
+    assert_int_equal(23, dst[1]);
+    assert_true(spsc_ring_consumer_is_empty(rx));
+
+    assert_int_equal(-1, spsc_ring_producer_push(NULL, 1));
+    assert_int_equal(0, spsc_ring_producer_push_bulk(NULL, src, 1));
+    assert_int_equal(-1, spsc_ring_consumer_pop(NULL, dst));
+    assert_int_equal(0, spsc_ring_consumer_pop_bulk(rx, NULL, 1));
+
+    spsc_ring_close_producer(&tx);
+    spsc_ring_close_consumer(&rx);
+    assert_int_equal(10, ring->prod.local.next);
+    assert_int_equal(10, ring->cons.local.next);
+    destroy_ring(&ring);
+}
+
+static void *endpoint_producer(void *arg)
+{
+    spsc_ring_producer_t *tx = spsc_ring_open_producer(arg);
+    if(tx == NULL)
+    {
+        return arg;
+    }
+    for(int i = 0; i < THREADED_ITEMS; ++i)
+    {
+        if(spsc_ring_producer_push_wait(tx, i, -1) != 0)
+        {
+            return arg;
+        }
+    }
+    spsc_ring_close_producer(&tx);
+    return NULL;
+}
+
+static void test_endpoints_threaded_blocking_fifo(void **state)
+{
+    (void)state;
+    spsc_ring_t *ring = spsc_ring_init_ex(64, SPSC_RING_BLOCKING);
+    assert_non_null(ring);
+    assert_int_equal(0, spsc_ring_set_prefetch(ring, 16));
+    spsc_ring_consumer_t *rx = spsc_ring_open_consumer(ring);
+    assert_non_null(rx);
+    assert_int_equal(16, rx->local.prefetch);
+
+    pthread_t producer;
+    assert_int_equal(0, pthread_create(&producer, NULL, endpoint_producer, ring));
+    int mismatches = 0;
+    for(int expected = 0; expected < THREADED_ITEMS; ++expected)
+    {
+        int value = -1;
+        assert_int_equal(0, spsc_ring_consumer_pop_wait(rx, &value, -1));
+        mismatches += (value != expected);
+    }
+    void *result = ring;
+    assert_int_equal(0, pthread_join(producer, &result));
+    assert_null(result);
+    assert_int_equal(0, mismatches);
+    assert_true(spsc_ring_consumer_is_empty(rx));
+
+    /* The absolute-deadline and eventfd forms exist on handles too. */
+    spsc_ring_producer_t *tx = spsc_ring_open_producer(ring);
+    assert_non_null(tx);
+    struct timespec past;
+    clock_gettime(CLOCK_MONOTONIC, &past);
+    int value = -1;
+    assert_int_equal(-1, spsc_ring_consumer_pop_wait_until(rx, &value, &past));
+    assert_int_equal(ETIMEDOUT, errno);
+    assert_int_equal(0, spsc_ring_producer_push_wait_until(tx, 5, &past));
+    assert_int_equal(0, spsc_ring_consumer_pop_wait_until(rx, &value, &past));
+    assert_int_equal(5, value);
+    assert_int_equal(-1, spsc_ring_producer_push_wait_until(NULL, 5, &past));
+    assert_int_equal(-1, spsc_ring_consumer_eventfd_drain(rx));   /* no eventfd */
+    assert_int_equal(-1, spsc_ring_consumer_eventfd_drain(NULL));
+    spsc_ring_close_producer(&tx);
+
+    spsc_ring_close_consumer(&rx);
+    spsc_ring_destroy(&ring);
+}
+
 static void test_destroy_handles_null_pointer(void **state)
 {
     (void)state;
@@ -131,9 +2469,65 @@ int main(void)
         cmocka_unit_test(test_init_rejects_invalid_capacity),
         cmocka_unit_test(test_push_pop_fifo_order),
         cmocka_unit_test(test_detects_full_ring),
+        cmocka_unit_test(test_every_slot_is_usable),
         cmocka_unit_test(test_pop_from_empty_ring),
         cmocka_unit_test(test_push_returns_error_when_ring_full),
         cmocka_unit_test(test_pop_succeeds_when_not_empty),
+        cmocka_unit_test(test_producer_sees_space_freed_by_consumer),
+        cmocka_unit_test(test_bulk_push_pop_wraps_around),
+        cmocka_unit_test(test_bulk_best_effort_and_all_or_nothing),
+        cmocka_unit_test(test_reserve_commit_spans_wrap),
+        cmocka_unit_test(test_peek_release_in_place),
+        cmocka_unit_test(test_inline_hot_path_mixes_with_library_calls),
+        cmocka_unit_test(test_typed_ring_large_records),
+        cmocka_unit_test(test_typed_ring_over_aligned_slots),
+        cmocka_unit_test(test_typed_ring_pointers),
+        cmocka_unit_test(test_msg_ring_variable_length_records),
+        cmocka_unit_test(test_msg_ring_reserve_commit_shorter),
+        cmocka_unit_test(test_threaded_fifo_order),
+        cmocka_unit_test(test_init_ex_rejects_unknown_flags),
+        cmocka_unit_test(test_wait_requires_blocking_ring),
+        cmocka_unit_test(test_wait_times_out),
+        cmocka_unit_test(test_threaded_blocking_handoff),
+        cmocka_unit_test(test_eventfd_signals_empty_to_non_empty),
+        cmocka_unit_test(test_threaded_eventfd_poll_loop),
+        cmocka_unit_test(test_shm_create_attach_share_one_ring),
+        cmocka_unit_test(test_shm_attach_rejects_missing_or_invalid),
+        cmocka_unit_test(test_shm_attach_rejects_corrupt_cfg),
+        cmocka_unit_test(test_shm_cross_process_fifo),
+        cmocka_unit_test(test_shm_blocking_flags_and_timeout),
+        cmocka_unit_test(test_shm_cross_process_blocking_handoff),
+        cmocka_unit_test(test_shm_claim_and_liveness),
+        cmocka_unit_test(test_shm_claimant_dying_mid_claim_is_replaced),
+        cmocka_unit_test(test_shm_producer_crash_and_recovery),
+        cmocka_unit_test(test_shm_claim_rejects_corrupt_indices),
+        cmocka_unit_test(test_file_ring_survives_clean_reopen),
+        cmocka_unit_test(test_file_ring_resumes_from_checkpoint_after_crash),
+        cmocka_unit_test(test_file_ring_producer_keeps_off_checkpointed_slots),
+        cmocka_unit_test(test_file_ring_periodic_checkpoint),
+        cmocka_unit_test(test_ring_dir_create_lookup_attach),
+        cmocka_unit_test(test_ring_dir_large_segment),
+        cmocka_unit_test(test_magic_ring_spans_never_wrap),
+        cmocka_unit_test(test_msg_ring_magic_never_pads),
+        cmocka_unit_test(test_msg_ring_blocking_eventfd_lazy),
+        cmocka_unit_test(test_init_in_caller_memory),
+        cmocka_unit_test(test_static_ring_fills_its_block),
+        cmocka_unit_test(test_heap_ring_slots_follow_structure),
+        cmocka_unit_test(test_page_flags_hugepage_populate),
+        cmocka_unit_test(test_page_flags_mlock),
+        cmocka_unit_test(test_init_numa_binds_to_cpu_node),
+        cmocka_unit_test(test_lazy_tail_publication),
+        cmocka_unit_test(test_lazy_head_returns_in_quarter_batches),
+        cmocka_unit_test(test_lazy_threaded_fifo),
+        cmocka_unit_test(test_sentinel_ring_fifo_without_indices),
+        cmocka_unit_test(test_sentinel_ring_probe_and_bulk),
+        cmocka_unit_test(test_sentinel_ring_threaded_fifo),
+        cmocka_unit_test(test_prefetch_distance_keeps_fifo),
+        cmocka_unit_test(test_copy_kernels_match_memcpy),
+        cmocka_unit_test(test_streaming_bulk_pushes),
+        cmocka_unit_test(test_endpoints_open_once_and_write_back),
+        cmocka_unit_test(test_endpoints_bulk_reserve_peek),
+        cmocka_unit_test(test_endpoints_threaded_blocking_fifo),
         cmocka_unit_test(test_destroy_handles_null_pointer),
         cmocka_unit_test(test_destroy_handles_null_ring_instance),
     };